@@ -34,7 +34,7 @@ public:
 	AnimatedSprite(const sf::Texture& tex, sf::Vector2i pFrameSize);
 	AnimatedSprite(const AnimatedSprite& other);
     void update(double dt);
-    void draw(sf::RenderWindow* win);
+    void draw(sf::RenderWindow* win, const sf::RenderStates& states = sf::RenderStates::Default);
     void addAnim(E id, const std::vector<unsigned int>& frames, double time, bool loop = false);
     void playAnim(E id);
     void selectFrame(int frame);
@@ -94,8 +94,8 @@ void AnimatedSprite<E>::update(double dt) {
 }
 
 template<typename E>
-void AnimatedSprite<E>::draw(sf::RenderWindow* win) {
-	win->draw(sprite);
+void AnimatedSprite<E>::draw(sf::RenderWindow* win, const sf::RenderStates& states) {
+	win->draw(sprite, states);
 }
 
 template<typename E>
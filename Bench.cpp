@@ -0,0 +1,610 @@
+#include <unordered_map>
+#include <deque>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <random>
+#include <tuple>
+
+#include <imgui.h>
+
+#include "Bench.h"
+#include "Lib.hpp"
+#include "WallMap.h"
+#include "PhysicsWorld.h"
+
+std::vector<Bench::Result> Bench::results;
+std::vector<std::string> Bench::checks;
+
+static volatile int sink = 0;
+
+void Bench::im(WallMap& wallMap) {
+	if (!ImGui::CollapsingHeader("Bench")) return;
+
+	if (ImGui::Button("Wall lookups")) wallLookups(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Level startup")) levelStartup(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Box destruction")) boxDestruction(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Physics 10k")) physics(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Integration")) integration(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Tunnelling")) tunnelling();
+	ImGui::SameLine();
+	if (ImGui::Button("Bullets 50k")) bullets(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Laser 1000")) laser(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Nav rebuild")) navRebuild(wallMap);
+	ImGui::SameLine();
+	if (ImGui::Button("Clear")) {
+		results.clear();
+		checks.clear();
+	}
+
+	for (const std::string& c : checks)
+		ImGui::TextUnformatted(c.c_str());
+	for (const Result& r : results)
+		ImGui::LabelText(r.name.c_str(), "%0.2f %s (%0.4f s)", r.opsPerSec / 1000000.0, r.unit.c_str(), r.seconds);
+}
+
+// units are per microsecond (Mops/s, entities/us...)
+void Bench::addResult(const std::string& name, double seconds, double ops, const std::string& unit) {
+	double opsPerSec = (seconds > 0.0) ? ops / seconds : 0.0;
+	results.push_back({ name, seconds, opsPerSec, unit });
+	std::cout << "BENCH " << name << " : " << opsPerSec / 1000000.0 << " " << unit << " (" << seconds << " s)" << std::endl;
+}
+
+void Bench::addCheck(const std::string& name, int failures, int cases) {
+	char line[128];
+	snprintf(line, sizeof(line), "%s : %s (%d / %d failed)", name.c_str(), (failures == 0) ? "PASS" : "FAIL", failures, cases);
+	checks.push_back(line);
+	std::cout << "CHECK " << line << std::endl;
+}
+
+// Replays the per-frame probe pattern of 1024 enemies (hitbox edges, ground,
+// patrol probes) against the previous hash map backend and the tile grid.
+void Bench::wallLookups(WallMap& wallMap) {
+	const int enemyCount = 1024;
+	const int frames = 120;
+
+	std::unordered_map<uint64_t, WallMap::WallType> hashed;
+	hashed.reserve(wallMap.walls.size());
+	for (const WallMap::Wall& w : wallMap.walls) hashed.emplace(w.key, w.type);
+
+	const TileGrid& grid = wallMap.tileGrid;
+	int minX = grid.chunkX0 * TileGrid::CHUNK_SIZE;
+	int minY = grid.chunkY0 * TileGrid::CHUNK_SIZE;
+	int maxX = std::max(minX, (grid.chunkX0 + grid.chunkCols) * TileGrid::CHUNK_SIZE - 1);
+	int maxY = std::max(minY, (grid.chunkY0 + grid.chunkRows) * TileGrid::CHUNK_SIZE - 1);
+
+	std::vector<sf::Vector2i> enemyCells;
+	enemyCells.reserve(enemyCount);
+	for (int i = 0; i < enemyCount; i++)
+		enemyCells.emplace_back(randi(minX, maxX), randi(minY, maxY));
+
+	const sf::Vector2i probes[] = {
+		{ -1, -1 }, { 0, -1 }, { 1, -1 },
+		{ -1, 0 }, { 1, 0 },
+		{ -1, 1 }, { 0, 1 }, { 1, 1 },
+		{ -2, 1 }, { 2, 1 }, { -2, 0 }, { 2, 0 }
+	};
+	const int probeCount = sizeof(probes) / sizeof(probes[0]);
+	double lookups = (double)enemyCount * frames * probeCount;
+
+	int hashHits = 0;
+	double start = Lib::getTimeStamp();
+	for (int f = 0; f < frames; f++)
+		for (const sf::Vector2i& e : enemyCells)
+			for (const sf::Vector2i& p : probes)
+				if (hashed.find(WallMap::getKey(e.x + p.x, e.y + p.y + (f & 1))) != hashed.end()) hashHits++;
+	addResult("isWall hash map", Lib::getTimeStamp() - start, lookups);
+
+	int gridHits = 0;
+	start = Lib::getTimeStamp();
+	for (int f = 0; f < frames; f++)
+		for (const sf::Vector2i& e : enemyCells)
+			for (const sf::Vector2i& p : probes)
+				if (wallMap.isWall(e.x + p.x, e.y + p.y + (f & 1))) gridHits++;
+	addResult("isWall tile grid", Lib::getTimeStamp() - start, lookups);
+
+	if (hashHits != gridHits) std::cout << "BENCH MISMATCH " << hashHits << " / " << gridHits << std::endl;
+	sink = hashHits + gridHits;
+}
+
+// Loads a 100k tile level through the previous per-tile path (hash insert and
+// Sprite construction per wall) and through the mapped level file.
+void Bench::levelStartup(WallMap& wallMap) {
+	const int cols = 500;
+	const int rows = 200;
+	const std::string path = "bench_level.enjl";
+
+	TileGrid source;
+	for (int y = 0; y < rows; y++)
+		for (int x = 0; x < cols; x++)
+			source.set(x, y, (uint8_t)randi(1, WallMap::WallType::Box + 1));
+	if (!LevelFile::write(path, source, {}, { 0.0f, 0.0f })) return;
+	double tileCount = (double)cols * rows;
+
+	double start = Lib::getTimeStamp();
+	{
+		std::unordered_map<uint64_t, WallMap::WallType> ids;
+		std::vector<sf::Sprite> sprites;
+		for (int y = 0; y < rows; y++)
+			for (int x = 0; x < cols; x++) {
+				uint64_t key = WallMap::getKey(x, y);
+				if (ids.find(key) != ids.end()) continue;
+				WallMap::WallType type = WallMap::WallType(source.get(x, y) - 1);
+				ids.emplace(key, type);
+				sf::Sprite sprite(wallMap.wallAtlas, { type * C::GRID_SIZE, 0, C::GRID_SIZE, C::GRID_SIZE });
+				sprite.setPosition((float)x * C::GRID_SIZE, (float)y * C::GRID_SIZE);
+				sprites.push_back(sprite);
+			}
+	}
+	addResult("Level startup addWall", Lib::getTimeStamp() - start, tileCount);
+
+	start = Lib::getTimeStamp();
+	{
+		LevelFile level;
+		TileGrid grid;
+		std::vector<WallMap::Wall> walls;
+		if (level.open(path)) WallMap::loadTiles(level, grid, walls);
+	}
+	addResult("Level startup mapped file", Lib::getTimeStamp() - start, tileCount);
+
+	std::remove(path.c_str());
+}
+
+// Destroys 10k boxes in random order, with the previous backward scan and
+// vector::erase, then through WallMap::removeWall. The boxes are placed
+// under the level and the map is left as it was.
+void Bench::boxDestruction(WallMap& wallMap) {
+	const int cols = 100;
+	const int rows = 100;
+	const int top = 64;
+
+	std::vector<sf::Vector2i> cells;
+	for (int y = top; y < top + rows; y++)
+		for (int x = 0; x < cols; x++)
+			cells.emplace_back(x, y);
+
+	std::vector<WallMap::Wall> legacyWalls = wallMap.walls;
+	for (const sf::Vector2i& c : cells) legacyWalls.push_back({ WallMap::getKey(c.x, c.y), WallMap::WallType::Box });
+	for (const sf::Vector2i& c : cells) wallMap.addWall(WallMap::WallType::Box, c.x, c.y);
+	std::shuffle(cells.begin(), cells.end(), rnd());
+
+	double start = Lib::getTimeStamp();
+	for (const sf::Vector2i& c : cells) {
+		uint64_t key = WallMap::getKey(c.x, c.y);
+		for (int i = (int)legacyWalls.size() - 1; i >= 0; i--)
+			if (legacyWalls[i].key == key) {
+				legacyWalls.erase(legacyWalls.begin() + i);
+				break;
+			}
+	}
+	addResult("Remove box scan + erase", Lib::getTimeStamp() - start, (double)cells.size());
+
+	start = Lib::getTimeStamp();
+	for (const sf::Vector2i& c : cells) wallMap.removeWall(c.x, c.y);
+	addResult("Remove box swap-and-pop", Lib::getTimeStamp() - start, (double)cells.size());
+}
+
+// Steps 10k enemy shaped bodies, spread over the loaded tiles, through the
+// per-object Entity::updatePhysics path and through PhysicsWorld (with and
+// without the gather/scatter WallMap does every tick), from the same start.
+void Bench::physics(WallMap& wallMap) {
+	const int count = 10000;
+	const int frames = 60;
+	const double dt = 1.0 / 120.0;
+	const float g = (float)C::GRID_SIZE;
+
+	const TileGrid& grid = wallMap.tileGrid;
+	float minX = grid.chunkX0 * TileGrid::CHUNK_SIZE * g;
+	float minY = grid.chunkY0 * TileGrid::CHUNK_SIZE * g;
+	float maxX = std::max(minX, (grid.chunkX0 + grid.chunkCols) * TileGrid::CHUNK_SIZE * g);
+	float maxY = std::max(minY, (grid.chunkY0 + grid.chunkRows) * TileGrid::CHUNK_SIZE * g);
+
+	// empty texture: the bodies never draw and this skips 20k image loads
+	sf::Texture empty;
+	std::deque<Entity> objects;
+	std::deque<Entity> batched;
+	for (int i = 0; i < count; i++) {
+		sf::Vector2f p = { randf(minX, maxX), randf(minY, maxY) };
+		float vx = randf(-200.0f, 200.0f);
+		float ax = randf(-50.0f, 50.0f);
+		for (std::deque<Entity>* set : { &objects, &batched }) {
+			Entity& e = set->emplace_back(wallMap, empty, sf::Vector2i(43, 42));
+			e.isPlayer = false;
+			e.isGrounded = false;
+			e.justJump = false;
+			e.scale = { 2.0f, 2.0f };
+			e.renderSize = { 86.0f, 84.0f };
+			e.leftPaddingBox = 26.0f;
+			e.rightPaddingBox = 26.0f;
+			e.topPaddingBox = 14.0f;
+			e.bottPaddingBox = 12.0f;
+			e.setPos(p);
+			e.setHitBoxes();
+			e.dx = vx;
+			e.addedX = ax;
+		}
+	}
+	double steps = (double)count * frames;
+
+	double start = Lib::getTimeStamp();
+	for (int f = 0; f < frames; f++)
+		for (Entity& e : objects) e.updatePhysics(dt);
+	addResult("Physics per-object", Lib::getTimeStamp() - start, steps);
+
+	PhysicsWorld world;
+	world.resize(count);
+	for (int i = 0; i < count; i++) world.setShape(i, batched[i]);
+
+	double stepTime = 0.0;
+	start = Lib::getTimeStamp();
+	for (int f = 0; f < frames; f++) {
+		for (int i = 0; i < count; i++) world.gather(i, batched[i]);
+		double stepStart = Lib::getTimeStamp();
+		world.step(dt, grid);
+		stepTime += Lib::getTimeStamp() - stepStart;
+		for (int i = 0; i < count; i++) world.scatter(i, batched[i]);
+	}
+	addResult("Physics SoA step + sync", Lib::getTimeStamp() - start, steps);
+	addResult("Physics SoA step", stepTime, steps);
+
+	int mismatches = 0;
+	for (int i = 0; i < count; i++)
+		if (objects[i].pos != batched[i].pos || objects[i].isGrounded != batched[i].isGrounded) mismatches++;
+	if (mismatches > 0) std::cout << "BENCH MISMATCH " << mismatches << " / " << count << std::endl;
+}
+
+// Gravity, velocity, integration and damping only (no tile collisions) for
+// 10k airborne bodies: the per-object Entity calls as reference, then the
+// PhysicsWorld loops scalar and SIMD. All three have to end bit-identical.
+void Bench::integration(WallMap& wallMap) {
+	const int count = 10000;
+	const int frames = 600;
+	const double dt = 1.0 / 120.0;
+
+	sf::Texture empty;
+	std::deque<Entity> objects;
+	for (int i = 0; i < count; i++) {
+		Entity& e = objects.emplace_back(wallMap, empty, sf::Vector2i(43, 42));
+		e.isPlayer = false;
+		e.isGrounded = (i % 5 == 0);
+		e.setPos(randf(0.0f, 10000.0f), randf(-10000.0f, 0.0f));
+		e.dx = randf(-200.0f, 200.0f);
+		e.dy = randf(-600.0f, 600.0f);
+		e.addedX = randf(-300.0f, 300.0f);
+		e.addedY = randf(-300.0f, 300.0f);
+	}
+
+	PhysicsWorld worlds[2];
+	for (int k = 0; k < 2; k++) {
+		worlds[k].resize(count);
+		worlds[k].useSimd = (k == 1);
+		for (int i = 0; i < count; i++) {
+			worlds[k].setShape(i, objects[i]);
+			worlds[k].gather(i, objects[i]);
+		}
+	}
+	double steps = (double)count * frames;
+
+	double start = Lib::getTimeStamp();
+	for (int f = 0; f < frames; f++)
+		for (Entity& e : objects) {
+			if (!e.isGrounded) e.applyGravity(dt);
+			e.handleAddedMovement(dt);
+			e.setMove(dt);
+			e.slowAddedMovement(dt);
+		}
+	addResult("Integration per-object", Lib::getTimeStamp() - start, steps, "entities/us");
+
+	for (PhysicsWorld& world : worlds) {
+		start = Lib::getTimeStamp();
+		for (int f = 0; f < frames; f++) {
+			world.applyGravity(dt);
+			world.applyVelocity();
+			world.integrate(dt);
+			world.dampAddedMovement();
+		}
+		std::string name = world.useSimd ? std::string("Integration SoA ") + PhysicsWorld::getSimdName() : "Integration SoA scalar";
+		addResult(name, Lib::getTimeStamp() - start, steps, "entities/us");
+	}
+
+	int mismatches = 0;
+	for (int i = 0; i < count; i++) {
+		const Entity& e = objects[i];
+		for (const PhysicsWorld& w : worlds)
+			if (memcmp(&e.pos.x, &w.posX[i], sizeof(float)) || memcmp(&e.pos.y, &w.posY[i], sizeof(float))
+				|| memcmp(&e.dy, &w.dy[i], sizeof(float)) || memcmp(&e.addedX, &w.addedX[i], sizeof(float))
+				|| memcmp(&e.addedY, &w.addedY[i], sizeof(float))) {
+				mismatches++;
+				break;
+			}
+	}
+	if (mismatches > 0) std::cout << "BENCH MISMATCH " << mismatches << " / " << count << std::endl;
+}
+
+// Regression check for tunnelling: enemy sized bodies are fired at a single
+// tile from its four sides, at recoil speeds and with steps up to half a
+// second, and must all end resting against the face they came from.
+void Bench::tunnelling() {
+	const float g = (float)C::GRID_SIZE;
+	const float boxW = 34.0f;
+	const float boxH = 58.0f;
+	const int tile = 20;
+	const float speeds[] = { 1000.0f, 3000.0f, 6000.0f, 20000.0f };
+	const double steps[] = { 1.0 / 120.0, 1.0 / 30.0, 1.0 / 10.0, 0.5 };
+
+	TileGrid grid;
+	grid.set(tile, tile, 1);
+	float tileMin = tile * g;
+	float tileMax = (tile + 1) * g;
+	float lane = tileMin + (g - std::max(boxW, boxH)) * 0.5f;
+
+	int failures = 0;
+	int cases = 0;
+	for (double dt : steps) {
+		PhysicsWorld world;
+		world.resize(16);
+		for (int i = 0; i < 16; i++) {
+			int side = i % 4;
+			float speed = speeds[i / 4];
+			world.boxW[i] = boxW;
+			world.boxH[i] = boxH;
+			world.dyMax[i] = speed;
+			world.flags[i] = PhysicsWorld::Active;
+			world.posX[i] = (side == 0) ? tileMin - boxW - 200.0f : (side == 1) ? tileMax + 200.0f : lane;
+			world.posY[i] = (side == 2) ? tileMin - boxH - 200.0f : (side == 3) ? tileMax + 200.0f : lane;
+			world.dx[i] = (side == 0) ? speed : (side == 1) ? -speed : 0.0f;
+			world.dy[i] = (side == 2) ? speed : (side == 3) ? -speed : 0.0f;
+		}
+		// at least a simulated second, every body reaches the tile
+		int stepCount = std::max(8, (int)(1.0 / dt));
+		for (int s = 0; s < stepCount; s++)
+			world.step(dt, grid);
+
+		for (int i = 0; i < 16; i++) {
+			int side = i % 4;
+			float gap = (side == 0) ? tileMin - (world.posX[i] + boxW)
+				: (side == 1) ? world.posX[i] - tileMax
+				: (side == 2) ? tileMin - (world.posY[i] + boxH)
+				: world.posY[i] - tileMax;
+			cases++;
+			if (gap < -0.01f || gap > 1.0f) failures++;
+		}
+	}
+	addCheck("Tunnelling single tile", failures, cases);
+}
+
+// the previous bullet layout: a sprite per bullet, copied in on spawn and
+// erased in place
+struct LegacyBullet {
+	sf::Sprite sprite;
+	sf::Vector2f pos;
+	sf::Vector2f prevPos;
+	sf::Vector2f direction;
+	float speed;
+};
+
+// 50k live bullets flying across a 4x4 screen field, each one leaving it
+// respawned at a random point: move, remove, spawn and reindex per tick.
+// The previous vector of sprites only runs a few ticks, its mid-array
+// erase being quadratic in the bullet count.
+void Bench::bullets(WallMap& wallMap) {
+	const int count = 50000;
+	const int frames = 120;
+	const int legacyFrames = 4;
+	const double dt = 1.0 / 120.0;
+	const float fieldW = C::RES_X * 4.0f;
+	const float fieldH = C::RES_Y * 4.0f;
+	auto isOut = [&](float x, float y) { return x < 0.0f || y < 0.0f || x > fieldW || y > fieldH; };
+
+	SpatialHash index;
+	BulletPool pool(BulletPool::CAPACITY);
+	pool.halfSize = wallMap.bullets.halfSize;
+	for (int i = 0; i < count; i++)
+		pool.spawn({ randf(0.0f, fieldW), randf(0.0f, fieldH) }, randf(0.0f, 360.0f), BulletPool::EnemyOwner);
+
+	int respawns = 0;
+	double start = Lib::getTimeStamp();
+	for (int f = 0; f < frames; f++) {
+		pool.savePrevPos();
+		pool.move(dt);
+		int removed = 0;
+		for (int i = 0; i < pool.size();) {
+			if (isOut(pool.posX[i], pool.posY[i])) {
+				pool.remove(i);
+				removed++;
+			}
+			else i++;
+		}
+		for (int i = 0; i < removed; i++)
+			pool.spawn({ randf(0.0f, fieldW), randf(0.0f, fieldH) }, randf(0.0f, 360.0f), BulletPool::EnemyOwner);
+		respawns += removed;
+		index.clear();
+		for (int i = 0; i < pool.size(); i++) index.insert(i, pool.getBounds(i));
+	}
+	addResult("Bullets pool tick", Lib::getTimeStamp() - start, (double)count * frames, "bullets/us");
+	// every respawn reuses a removed bullet's index, none may be dropped
+	addCheck("Bullets pool respawns", pool.dropped, respawns);
+
+	std::vector<LegacyBullet> legacy;
+	for (int i = 0; i < count; i++) {
+		float a = randf(0.0f, 360.0f);
+		LegacyBullet b;
+		b.sprite.setTexture(wallMap.bullets.texture);
+		b.sprite.setRotation(a);
+		b.sprite.setScale(1.0f, 2.0f);
+		b.pos = b.prevPos = { randf(0.0f, fieldW), randf(0.0f, fieldH) };
+		b.direction = { std::cos(a * C::PI / 180.0f), std::sin(a * C::PI / 180.0f) };
+		b.speed = BulletPool::SPEED;
+		legacy.push_back(b);
+	}
+
+	start = Lib::getTimeStamp();
+	for (int f = 0; f < legacyFrames; f++) {
+		for (LegacyBullet& b : legacy) b.prevPos = b.pos;
+		int removed = 0;
+		for (int i = (int)legacy.size() - 1; i >= 0; i--) {
+			LegacyBullet& b = legacy[i];
+			b.pos += b.direction * b.speed * (float)dt;
+			b.sprite.setPosition(b.pos);
+			if (isOut(b.pos.x, b.pos.y)) {
+				legacy.erase(legacy.begin() + i);
+				removed++;
+			}
+		}
+		for (int i = 0; i < removed; i++) {
+			float a = randf(0.0f, 360.0f);
+			LegacyBullet b = legacy.front();
+			b.sprite.setRotation(a);
+			b.pos = b.prevPos = { randf(0.0f, fieldW), randf(0.0f, fieldH) };
+			b.direction = { std::cos(a * C::PI / 180.0f), std::sin(a * C::PI / 180.0f) };
+			legacy.push_back(b);
+		}
+		index.clear();
+		for (int i = 0; i < (int)legacy.size(); i++) index.insert(i, legacy[i].sprite.getGlobalBounds());
+	}
+	addResult("Bullets sprite vector tick", Lib::getTimeStamp() - start, (double)count * legacyFrames, "bullets/us");
+}
+
+// 1000 enemy boxes over the current view and 10k laser queries from random
+// points of it: the previous 20 px march (isWall and every box per step),
+// the DDA raycast with a slab test on every box, and the same with the
+// boxes along the segment from the spatial hash. The last two have to agree.
+void Bench::laser(WallMap& wallMap) {
+	const int enemyCount = 1000;
+	const int queryCount = 10000;
+	const float maxLen = 2000.0f;
+	const float g = (float)C::GRID_SIZE;
+
+	sf::FloatRect view = wallMap.getViewRect(0.0f);
+	SpatialHash index;
+	std::vector<sf::FloatRect> boxes;
+	for (int i = 0; i < enemyCount; i++) {
+		boxes.push_back({ randf(view.left, view.left + view.width), randf(view.top, view.top + view.height), 34.0f, 58.0f });
+		index.insert(i, boxes.back());
+	}
+	std::vector<sf::Vector2f> starts;
+	std::vector<sf::Vector2f> dirs;
+	for (int i = 0; i < queryCount; i++) {
+		starts.push_back({ randf(view.left, view.left + view.width), randf(view.top, view.top + view.height) });
+		dirs.push_back(getForward(randf(0.0f, 360.0f)));
+	}
+
+	double marchSum = 0.0;
+	double start = Lib::getTimeStamp();
+	for (int q = 0; q < queryCount; q++) {
+		float dist = 0.0f;
+		for (; dist < maxLen; dist += 20.0f) {
+			sf::Vector2f p = starts[q] + dirs[q] * dist;
+			if (wallMap.isWall(int(p.x / g), int(p.y / g))) break;
+			bool isHit = false;
+			for (const sf::FloatRect& b : boxes)
+				if (b.contains(p)) isHit = true;
+			if (isHit) break;
+		}
+		marchSum += std::min(dist, maxLen);
+	}
+	addResult("Laser 20 px march", Lib::getTimeStamp() - start, queryCount);
+
+	std::vector<float> scanLens(queryCount);
+	start = Lib::getTimeStamp();
+	for (int q = 0; q < queryCount; q++) {
+		float len = wallMap.raycast(starts[q], dirs[q], maxLen).dist;
+		float t;
+		for (const sf::FloatRect& b : boxes)
+			if (rayIntersectsRect(starts[q], dirs[q], b, len, t)) len = t;
+		scanLens[q] = len;
+	}
+	addResult("Laser DDA + every box", Lib::getTimeStamp() - start, queryCount);
+
+	std::vector<int> ids;
+	int mismatches = 0;
+	start = Lib::getTimeStamp();
+	for (int q = 0; q < queryCount; q++) {
+		float len = wallMap.raycast(starts[q], dirs[q], maxLen).dist;
+		float t;
+		index.querySegment(starts[q], starts[q] + dirs[q] * len, ids);
+		for (int id : ids)
+			if (rayIntersectsRect(starts[q], dirs[q], boxes[id], len, t)) len = t;
+		if (len != scanLens[q]) mismatches++;
+	}
+	addResult("Laser DDA + broadphase", Lib::getTimeStamp() - start, queryCount);
+	addCheck("Laser broadphase vs every box", mismatches, queryCount);
+	sink = (int)marchSum;
+}
+
+// Regression check for NavGraph::rebuild: random tile edits, single cells
+// and small rects, are applied to a platform grid and rebuilt in place, and
+// after each one the spans and links must be the ones a fresh build gives.
+void Bench::navRebuild(WallMap& wallMap) {
+	const NavGraph& live = wallMap.nav;
+	const int cols = TileGrid::CHUNK_SIZE * 4;
+	const int rows = TileGrid::CHUNK_SIZE * 2;
+	const int editCount = 300;
+	std::mt19937 gen(7);
+	auto roll = [&gen](int n) { return (int)(gen() % (uint32_t)n); };
+
+	TileGrid grid;
+	for (int x = 0; x < cols; x++) grid.set(x, rows - 1, 1);
+	for (int p = 0; p < 60; p++) {
+		int x = roll(cols - 8);
+		int y = 4 + roll(rows - 8);
+		for (int len = 2 + roll(8); len > 0; len--) grid.set(x++, y, 1);
+	}
+
+	// spans by (y, x0, x1), links by their two spans, so the node ids of
+	// both graphs do not have to match
+	using Span = std::tuple<int, int, int>;
+	using LinkKey = std::tuple<Span, Span, int, int, int, int, float>;
+	auto snapshot = [](const NavGraph& nav, std::vector<Span>& spans, std::vector<LinkKey>& links) {
+		spans.clear();
+		links.clear();
+		for (const NavGraph::Node& n : nav.nodes) {
+			if (!n.isAlive) continue;
+			Span from = { n.y, n.x0, n.x1 };
+			spans.push_back(from);
+			for (const NavGraph::Link& l : n.links) {
+				const NavGraph::Node& to = nav.nodes[l.to];
+				links.push_back({ from, { to.y, to.x0, to.x1 }, l.type, l.dir, l.fromX, l.toX, l.cost });
+			}
+		}
+		std::sort(spans.begin(), spans.end());
+		std::sort(links.begin(), links.end());
+	};
+
+	NavGraph incremental(live.cellSize, live.jumpSpeed, live.gravity, live.runSpeed);
+	incremental.build(grid);
+	std::vector<Span> spans, freshSpans;
+	std::vector<LinkKey> links, freshLinks;
+	int failures = 0;
+	double rebuildTime = 0.0;
+	for (int e = 0; e < editCount; e++) {
+		sf::IntRect cells = { roll(cols), 1 + roll(rows - 2), 1, 1 };
+		if (e % 5 == 0) {
+			cells.width = 1 + roll(4);
+			cells.height = 1 + roll(3);
+		}
+		for (int y = cells.top; y < cells.top + cells.height; y++)
+			for (int x = cells.left; x < cells.left + cells.width; x++)
+				grid.set(x, y, (grid.get(x, y) == TileGrid::EMPTY) ? 1 : TileGrid::EMPTY);
+
+		double start = Lib::getTimeStamp();
+		incremental.rebuild(grid, cells);
+		rebuildTime += Lib::getTimeStamp() - start;
+
+		NavGraph fresh(live.cellSize, live.jumpSpeed, live.gravity, live.runSpeed);
+		fresh.build(grid);
+		snapshot(incremental, spans, links);
+		snapshot(fresh, freshSpans, freshLinks);
+		if (spans != freshSpans || links != freshLinks) failures++;
+	}
+	addResult("Nav rebuild", rebuildTime, editCount, "edits/us");
+	addCheck("Nav rebuild vs full build", failures, editCount);
+}
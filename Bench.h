@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+class WallMap;
+
+// In-game micro benchmarks, run from the "Bench" ImGui panel.
+// Each run pushes one Result per measured backend. Regression checks push
+// a pass/fail line into checks.
+class Bench
+{
+public:
+	struct Result {
+		std::string name;
+		double seconds;
+		double opsPerSec;
+		std::string unit;
+	};
+
+	static std::vector<Result> results;
+	static std::vector<std::string> checks;
+
+	static void im(WallMap& wallMap);
+	static void addResult(const std::string& name, double seconds, double ops, const std::string& unit = "Mops/s");
+	static void addCheck(const std::string& name, int failures, int cases);
+
+	static void wallLookups(WallMap& wallMap);
+	static void levelStartup(WallMap& wallMap);
+	static void boxDestruction(WallMap& wallMap);
+	static void physics(WallMap& wallMap);
+	static void integration(WallMap& wallMap);
+	static void tunnelling();
+	static void bullets(WallMap& wallMap);
+	static void laser(WallMap& wallMap);
+	static void navRebuild(WallMap& wallMap);
+};
@@ -0,0 +1,129 @@
+#include <cmath>
+#include <algorithm>
+
+#include "BulletPool.h"
+#include "C.hpp"
+#include "EffectsManager.h"
+#include "Player.h"
+#include "WallMap.h"
+
+BulletPool::BulletPool(int pCapacity) : capacity(pCapacity) {
+	for (std::vector<float>* a : { &posX, &posY, &prevX, &prevY, &dirX, &dirY, &speed, &angle })
+		a->resize(capacity);
+	owner.resize(capacity);
+}
+
+bool BulletPool::loadTexture(const std::string& path) {
+	if (!texture.loadFromFile(path)) return false;
+	texSize = { (float)texture.getSize().x, (float)texture.getSize().y };
+	halfSize = { texSize.x * 0.5f, texSize.y };
+	return true;
+}
+
+// the sprite rotated by the bullet angle, whose cosine and sine are dir
+sf::FloatRect BulletPool::getBounds(int i) const {
+	float c = std::abs(dirX[i]);
+	float s = std::abs(dirY[i]);
+	float ex = c * halfSize.x + s * halfSize.y;
+	float ey = s * halfSize.x + c * halfSize.y;
+	return { posX[i] - ex, posY[i] - ey, ex * 2.0f, ey * 2.0f };
+}
+
+int BulletPool::spawn(sf::Vector2f pos, float pAngle, Owner pOwner) {
+	if (count == capacity) {
+		dropped++;
+		return -1;
+	}
+	int i = count++;
+	posX[i] = prevX[i] = pos.x;
+	posY[i] = prevY[i] = pos.y;
+	dirX[i] = std::cos(pAngle * C::PI / 180.0f);
+	dirY[i] = std::sin(pAngle * C::PI / 180.0f);
+	speed[i] = SPEED;
+	angle[i] = pAngle;
+	owner[i] = pOwner;
+	return i;
+}
+
+// swap-and-pop: the last bullet takes index i
+void BulletPool::remove(int i) {
+	int last = --count;
+	if (i == last) return;
+	posX[i] = posX[last];
+	posY[i] = posY[last];
+	prevX[i] = prevX[last];
+	prevY[i] = prevY[last];
+	dirX[i] = dirX[last];
+	dirY[i] = dirY[last];
+	speed[i] = speed[last];
+	angle[i] = angle[last];
+	owner[i] = owner[last];
+}
+
+void BulletPool::clear() {
+	count = 0;
+}
+
+void BulletPool::savePrevPos() {
+	std::copy(posX.begin(), posX.begin() + count, prevX.begin());
+	std::copy(posY.begin(), posY.begin() + count, prevY.begin());
+}
+
+void BulletPool::move(double dt) {
+	float fdt = (float)dt;
+	for (int i = 0; i < count; i++) {
+		posX[i] += dirX[i] * speed[i] * fdt;
+		posY[i] += dirY[i] * speed[i] * fdt;
+	}
+}
+
+// true when bullet i is gone: hit something or left the view
+bool BulletPool::checkCollision(int i, WallMap& wallMap, sf::Vector2f viewCenter) {
+	if (handleCollision(i, wallMap)) return true;
+	float x = posX[i];
+	return (x > viewCenter.x + C::RES_X / 2) || (x < viewCenter.x - C::RES_X / 2) || (posY[i] < 0.0f);
+}
+
+// Sweeps the move of this tick, from the previous position, through the
+// tile grid (DDA) and against the player and enemy hitboxes, see
+// WallMap::sweepShot. The bullet is put at the contact point for the
+// explosion.
+bool BulletPool::handleCollision(int i, WallMap& wallMap) {
+	sf::Vector2f start = { prevX[i], prevY[i] };
+	sf::Vector2f dir = getDir(i);
+	float len = std::sqrt(getDistanceSquared(start, getPos(i)));
+
+	WallMap::ShotHit hit = wallMap.sweepShot(start, dir, len, wallMap.raycast(start, dir, len));
+	if (!hit.isHit) return false;
+	posX[i] = start.x + dir.x * hit.dist;
+	posY[i] = start.y + dir.y * hit.dist;
+	playExplosion(getPos(i), dir, angle[i]);
+	wallMap.applyShotHit(hit, dir);
+	return true;
+}
+
+void BulletPool::playExplosion(sf::Vector2f pos, sf::Vector2f dir, float pAngle) {
+	float rot = pAngle + 45.0f;
+	float scl = randf(0.7f, 1.8f);
+	EffectsManager::Instance().playAnimEffect(EffectsManager::AnimEffectType::Explosion, pos + (dir * 10.0f), rot, { scl, scl });
+}
+
+// Draws the bullets in ids at their previous position plus alpha of the
+// last move. The vertex array only grows, resizing down keeps its storage.
+void BulletPool::draw(sf::RenderWindow& win, const std::vector<int>& ids, float alpha) {
+	vertices.resize(ids.size() * 4);
+	for (int k = 0; k < (int)ids.size(); k++) {
+		int i = ids[k];
+		float x = prevX[i] + (posX[i] - prevX[i]) * alpha;
+		float y = prevY[i] + (posY[i] - prevY[i]) * alpha;
+		// half axes of the quad, rotated by the angle whose cosine and sine are dir
+		sf::Vector2f u = { dirX[i] * halfSize.x, dirY[i] * halfSize.x };
+		sf::Vector2f v = { -dirY[i] * halfSize.y, dirX[i] * halfSize.y };
+		sf::Vertex* quad = &vertices[k * 4];
+		quad[0] = sf::Vertex({ x - u.x - v.x, y - u.y - v.y }, { 0.0f, 0.0f });
+		quad[1] = sf::Vertex({ x + u.x - v.x, y + u.y - v.y }, { texSize.x, 0.0f });
+		quad[2] = sf::Vertex({ x + u.x + v.x, y + u.y + v.y }, { texSize.x, texSize.y });
+		quad[3] = sf::Vertex({ x - u.x + v.x, y - u.y + v.y }, { 0.0f, texSize.y });
+	}
+	if (!ids.empty()) win.draw(vertices, &texture);
+}
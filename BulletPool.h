@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "SFML/Graphics.hpp"
+
+class WallMap;
+
+// Every live bullet, structure-of-arrays, bullet i being index i of each
+// array. The arrays are sized once to the capacity: spawn never allocates
+// and fails (counted in dropped) when the pool is full. remove() moves the
+// last bullet into the freed index, so the live bullets stay packed in
+// [0, count) and indices are only valid until the next removal.
+// All bullets share one texture and are drawn as rotated quads of a single
+// vertex array, rebuilt each frame in place: one draw call for all of them.
+class BulletPool
+{
+public:
+	enum Owner : uint8_t {
+		PlayerOwner,
+		EnemyOwner
+	};
+
+	static constexpr int CAPACITY = 65536;
+	static constexpr float SPEED = 1600.0f;
+
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> prevX;
+	std::vector<float> prevY;
+	std::vector<float> dirX;
+	std::vector<float> dirY;
+	std::vector<float> speed;
+	std::vector<float> angle;
+	std::vector<uint8_t> owner;
+	int count = 0;
+	int capacity = 0;
+	int dropped = 0;
+
+	sf::Texture texture;
+	sf::Vector2f texSize;
+	sf::Vector2f halfSize;	// quad at the (1, 2) scale, before rotation
+	sf::VertexArray vertices{ sf::Quads };
+
+	BulletPool(int pCapacity = CAPACITY);
+	bool loadTexture(const std::string& path);
+	int size() const { return count; }
+	sf::Vector2f getPos(int i) const { return { posX[i], posY[i] }; }
+	sf::Vector2f getDir(int i) const { return { dirX[i], dirY[i] }; }
+	sf::FloatRect getBounds(int i) const;
+
+	int spawn(sf::Vector2f pos, float pAngle, Owner pOwner);
+	void remove(int i);
+	void clear();
+	void savePrevPos();
+	void move(double dt);
+	bool checkCollision(int i, WallMap& wallMap, sf::Vector2f viewCenter);
+	bool handleCollision(int i, WallMap& wallMap);
+	void draw(sf::RenderWindow& win, const std::vector<int>& ids, float alpha = 1.0f);
+
+	static void playExplosion(sf::Vector2f pos, sf::Vector2f dir, float pAngle);
+};
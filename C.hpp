@@ -1,6 +1,8 @@
 #pragma once
 
 #include<random>
+#include<cstdint>
+#include<cstdlib>
 
 namespace C {
 	static constexpr int GRID_SIZE = 64;
@@ -50,15 +52,45 @@ inline float getDistanceSquared(sf::Vector2f a, sf::Vector2f b) {
 	return dx * dx + dy * dy;
 }
 
+// slab test, tHit is the entry distance along dir (0 when origin is inside)
+inline bool rayIntersectsRect(sf::Vector2f origin, sf::Vector2f dir, const sf::FloatRect& r, float maxDist, float& tHit) {
+	float tMin = 0.0f;
+	float tMax = maxDist;
+	const float o[2] = { origin.x, origin.y };
+	const float d[2] = { dir.x, dir.y };
+	const float lo[2] = { r.left, r.top };
+	const float hi[2] = { r.left + r.width, r.top + r.height };
+	for (int a = 0; a < 2; a++) {
+		if (d[a] == 0.0f) {
+			if (o[a] < lo[a] || o[a] > hi[a]) return false;
+			continue;
+		}
+		float inv = 1.0f / d[a];
+		float t0 = (lo[a] - o[a]) * inv;
+		float t1 = (hi[a] - o[a]) * inv;
+		if (t0 > t1) std::swap(t0, t1);
+		if (t0 > tMin) tMin = t0;
+		if (t1 < tMax) tMax = t1;
+		if (tMin > tMax) return false;
+	}
+	tHit = tMin;
+	return true;
+}
+
 inline std::mt19937& rnd() {
 	static std::mt19937 gen{ std::random_device{}() };
 	return gen;
 }
 
 inline bool randBool() {
-	static std::mt19937 gen{ std::random_device{}() };
-	static std::bernoulli_distribution coin(0.5);
-	return coin(gen);
+	std::bernoulli_distribution coin(0.5);
+	return coin(rnd());
+}
+
+// replays start from a known seed, see Game::restart
+inline void seedRandom(uint32_t seed) {
+	rnd().seed(seed);
+	srand(seed);
 }
 
 inline int randi(int a, int b) {
@@ -0,0 +1,97 @@
+#include <algorithm>
+
+#include "ChangeLog.h"
+
+void ChangeLog::mark(int x, int y) {
+	markRect({ x, y, 1, 1 });
+}
+
+static sf::IntRect unite(const sf::IntRect& a, const sf::IntRect& b) {
+	int x0 = std::min(a.left, b.left);
+	int y0 = std::min(a.top, b.top);
+	int x1 = std::max(a.left + a.width, b.left + b.width);
+	int y1 = std::max(a.top + a.height, b.top + b.height);
+	return { x0, y0, x1 - x0, y1 - y0 };
+}
+
+// merged into the first pending rect it touches, edits in combat are
+// mostly clustered around a few explosions
+void ChangeLog::markRect(const sf::IntRect& cells) {
+	sf::IntRect grown = { cells.left - 1, cells.top - 1, cells.width + 2, cells.height + 2 };
+	for (sf::IntRect& r : pending)
+		if (r.intersects(grown)) {
+			r = unite(r, cells);
+			return;
+		}
+
+	if ((int)pending.size() < maxPendingRects) pending.push_back(cells);
+	else pending.back() = unite(pending.back(), cells);
+}
+
+// the whole map changed, every consumer rebuilds
+void ChangeLog::reset() {
+	pending.clear();
+	changes.clear();
+	version++;
+	resetVersion = version;
+}
+
+void ChangeLog::commit() {
+	if (pending.empty()) return;
+	version++;
+	for (const sf::IntRect& r : pending) changes.push_back({ version, r });
+	pending.clear();
+	trim();
+}
+
+int ChangeLog::subscribe() {
+	for (int i = 0; i < (int)isSubscribed.size(); i++)
+		if (!isSubscribed[i]) {
+			isSubscribed[i] = true;
+			subscribers[i] = version;
+			return i;
+		}
+	subscribers.push_back(version);
+	isSubscribed.push_back(true);
+	return (int)subscribers.size() - 1;
+}
+
+void ChangeLog::unsubscribe(int id) {
+	if (id >= 0 && id < (int)isSubscribed.size()) isSubscribed[id] = false;
+}
+
+bool ChangeLog::pull(int id, std::vector<sf::IntRect>& out) {
+	bool isComplete = getChangesSince(subscribers[id], out);
+	subscribers[id] = version;
+	trim();
+	return isComplete;
+}
+
+bool ChangeLog::getChangesSince(uint32_t since, std::vector<sf::IntRect>& out) const {
+	out.clear();
+	if (since < resetVersion) return false;
+	auto first = std::upper_bound(changes.begin(), changes.end(), since,
+		[](uint32_t v, const Change& c) { return v < c.version; });
+	for (auto it = first; it != changes.end(); ++it) out.push_back(it->cells);
+	return true;
+}
+
+// drops what every subscriber has seen, and the oldest entries past
+// maxChanges, moving resetVersion up so late readers know to rebuild
+void ChangeLog::trim() {
+	uint32_t seen = version;
+	bool hasSubscriber = false;
+	for (int i = 0; i < (int)subscribers.size(); i++)
+		if (isSubscribed[i]) {
+			seen = std::min(seen, subscribers[i]);
+			hasSubscriber = true;
+		}
+
+	while (!changes.empty()) {
+		const Change& c = changes.front();
+		bool isSeen = hasSubscriber && c.version <= seen;
+		if (!isSeen && changes.size() <= maxChanges) break;
+		resetVersion = std::max(resetVersion, c.version);
+		changes.pop_front();
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstdint>
+
+#include <SFML/Graphics/Rect.hpp>
+
+// Versioned log of edited cell rects, for caches derived from the map.
+// Edits are merged into a few pending rects and committed once per tick
+// under a new version. A consumer either subscribes and pulls what changed
+// since its last pull, or keeps its own version and asks getChangesSince.
+// Rects only cover the edited cells, consumers of neighbourhood data widen
+// them as they need. A false return means the history was dropped (level
+// reload, log full) and the consumer has to rebuild everything.
+class ChangeLog
+{
+public:
+	struct Change {
+		uint32_t version;
+		sf::IntRect cells;
+	};
+
+	uint32_t version = 0;
+	uint32_t resetVersion = 0;
+	std::deque<Change> changes;
+	std::vector<sf::IntRect> pending;
+	std::vector<uint32_t> subscribers;
+	std::vector<bool> isSubscribed;
+	int maxPendingRects = 16;
+	size_t maxChanges = 4096;
+
+	void mark(int x, int y);
+	void markRect(const sf::IntRect& cells);
+	void reset();
+	void commit();
+	int subscribe();
+	void unsubscribe(int id);
+	bool pull(int id, std::vector<sf::IntRect>& out);
+	bool getChangesSince(uint32_t since, std::vector<sf::IntRect>& out) const;
+
+private:
+	void trim();
+};
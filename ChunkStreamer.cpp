@@ -0,0 +1,135 @@
+#include <cstring>
+
+#include "ChunkStreamer.h"
+
+ChunkStreamer::~ChunkStreamer() {
+	close();
+}
+
+bool ChunkStreamer::open(const std::string& path) {
+	close();
+	if (!level.open(path)) return false;
+
+	const LevelFile::Header& h = *level.header;
+	entries.reserve(h.chunkCount);
+	for (int i = 0; i < h.chunkCount; i++)
+		entries[getKey(level.chunkTable[i].cx, level.chunkTable[i].cy)] = i;
+	spawnStates.assign(h.enemyCount, Waiting);
+
+	isStopping = false;
+	worker = std::thread(&ChunkStreamer::run, this);
+	return true;
+}
+
+void ChunkStreamer::close() {
+	if (worker.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			isStopping = true;
+		}
+		wakeUp.notify_one();
+		worker.join();
+	}
+	requests.clear();
+	finished.clear();
+	entries.clear();
+	slots.clear();
+	overrides.clear();
+	extraSpawns.clear();
+	generations.clear();
+	spawnStates.clear();
+	level.close();
+}
+
+bool ChunkStreamer::hasChunk(uint64_t key) const {
+	return entries.count(key) || overrides.count(key) || extraSpawns.count(key);
+}
+
+// queues the chunk for the worker, returns false when there is nothing to load
+bool ChunkStreamer::request(int cx, int cy, uint32_t generation) {
+	uint64_t key = getKey(cx, cy);
+	if (!hasChunk(key)) return false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		requests.push_back({ key, generation });
+	}
+	wakeUp.notify_one();
+	return true;
+}
+
+bool ChunkStreamer::poll(LoadedChunk& out) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (finished.empty()) return false;
+	out = std::move(finished.front());
+	finished.pop_front();
+	return true;
+}
+
+// synchronous path, for edits landing on a chunk that is not resident yet
+void ChunkStreamer::loadNow(int cx, int cy, LoadedChunk& out) {
+	uint64_t key = getKey(cx, cy);
+	read(key, out);
+	std::lock_guard<std::mutex> lock(mutex);
+	applyOverride(key, out);
+}
+
+void ChunkStreamer::storeOverride(uint64_t key, const uint8_t* ids) {
+	std::lock_guard<std::mutex> lock(mutex);
+	std::memcpy(overrides[key].data(), ids, TileGrid::CHUNK_CELLS);
+}
+
+void ChunkStreamer::dropOverride(uint64_t key) {
+	std::lock_guard<std::mutex> lock(mutex);
+	overrides.erase(key);
+}
+
+int ChunkStreamer::getPendingCount() {
+	std::lock_guard<std::mutex> lock(mutex);
+	return (int)(requests.size() + finished.size());
+}
+
+uint64_t ChunkStreamer::getKey(int cx, int cy) {
+	return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
+}
+
+void ChunkStreamer::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wakeUp.wait(lock, [this] { return isStopping || !requests.empty(); });
+		if (isStopping) return;
+		auto [key, generation] = requests.front();
+		requests.pop_front();
+
+		lock.unlock();
+		LoadedChunk loaded;
+		read(key, loaded);
+		loaded.generation = generation;
+		lock.lock();
+		applyOverride(key, loaded);
+		finished.push_back(std::move(loaded));
+	}
+}
+
+// only reads the mapping and the chunk table, which do not change while the
+// worker runs, so the copy (and the page faults) happen outside the lock
+void ChunkStreamer::read(uint64_t key, LoadedChunk& out) const {
+	out.cx = int32_t(key >> 32);
+	out.cy = int32_t(key & 0xFFFFFFFFu);
+	out.ids.fill(TileGrid::EMPTY);
+	out.spawns.clear();
+	out.spawnFirst = 0;
+
+	auto entry = entries.find(key);
+	if (entry == entries.end()) return;
+	const LevelFile::ChunkEntry& e = level.chunkTable[entry->second];
+	out.spawnFirst = e.enemyFirst;
+	for (uint32_t i = 0; i < e.enemyCount; i++)
+		out.spawns.emplace_back(level.spawns[e.enemyFirst + i].x, level.spawns[e.enemyFirst + i].y);
+	std::memcpy(out.ids.data(), level.getTiles(e), TileGrid::CHUNK_CELLS);
+}
+
+// edits win over the file, called with the lock held
+void ChunkStreamer::applyOverride(uint64_t key, LoadedChunk& out) const {
+	auto edited = overrides.find(key);
+	if (edited != overrides.end()) out.ids = edited->second;
+}
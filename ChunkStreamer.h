@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <condition_variable>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "TileGrid.h"
+#include "LevelFile.h"
+
+// Pages the chunks of a level file in and out around a focus rect.
+// The file stays mapped for the whole session; a worker thread copies the
+// requested tile blocks and spawns out of the mapping, so page faults on a
+// cold file never hit the main thread. WallMap pulls the finished chunks
+// with poll() and integrates a bounded number of them per frame.
+// Edited chunks are kept as overrides when evicted, and spawn states
+// remember which enemies are alive, dead or waiting for their chunk.
+// Each request carries the generation of its chunk, bumped on every
+// request, synchronous load and eviction: only the result of the latest
+// request is integrated, a late one from before an edit is dropped.
+class ChunkStreamer
+{
+public:
+	enum ChunkState {
+		Queued,
+		Resident
+	};
+
+	enum SpawnState : uint8_t {
+		Waiting,
+		Spawned,
+		Killed
+	};
+
+	struct Slot {
+		ChunkState state = Queued;
+		bool isEdited = false;
+		uint32_t generation = 0;
+	};
+
+	struct LoadedChunk {
+		int cx = 0;
+		int cy = 0;
+		uint32_t generation = 0;
+		std::array<uint8_t, TileGrid::CHUNK_CELLS> ids{};
+		uint32_t spawnFirst = 0;
+		std::vector<sf::Vector2f> spawns;
+	};
+
+	LevelFile level;
+	std::unordered_map<uint64_t, int> entries;
+	std::unordered_map<uint64_t, Slot> slots;
+	std::unordered_map<uint64_t, std::array<uint8_t, TileGrid::CHUNK_CELLS>> overrides;
+	std::unordered_map<uint64_t, std::vector<sf::Vector2f>> extraSpawns;
+	std::unordered_map<uint64_t, uint32_t> generations;
+	std::vector<SpawnState> spawnStates;
+	int loadRadius = 1;
+	int evictRadius = 2;
+	int maxChunksPerFrame = 2;
+	int maxSpawnsPerFrame = 4;
+
+	ChunkStreamer() = default;
+	ChunkStreamer(const ChunkStreamer&) = delete;
+	ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+	~ChunkStreamer();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return level.isOpen(); }
+	bool hasChunk(uint64_t key) const;
+	bool request(int cx, int cy, uint32_t generation);
+	bool poll(LoadedChunk& out);
+	void loadNow(int cx, int cy, LoadedChunk& out);
+	void storeOverride(uint64_t key, const uint8_t* ids);
+	void dropOverride(uint64_t key);
+	int getPendingCount();
+	uint32_t nextGeneration(uint64_t key) { return ++generations[key]; }
+
+	static uint64_t getKey(int cx, int cy);
+
+private:
+	std::thread worker;
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	std::deque<std::pair<uint64_t, uint32_t>> requests;
+	std::deque<LoadedChunk> finished;
+	bool isStopping = false;
+
+	void run();
+	void read(uint64_t key, LoadedChunk& out) const;
+	void applyOverride(uint64_t key, LoadedChunk& out) const;
+};
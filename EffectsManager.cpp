@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cmath>
+
 #include "EffectsManager.h"
 
 EffectsManager::EffectsManager() {
@@ -6,6 +9,8 @@ EffectsManager::EffectsManager() {
 }
 
 void EffectsManager::update(double dt) {
+	updateTracers(dt);
+	visIndex.clear();
 	if (animEffToPlay.empty()) return;
 	for (int i = (int)animEffToPlay.size() - 1; i >= 0; i--) {
 		PlayingEffect& data = animEffToPlay[i];
@@ -33,11 +38,66 @@ void EffectsManager::update(double dt) {
 			eff.sprite.setTextureRect(sf::IntRect(u, v, eff.frameSize.x, eff.frameSize.y));
 		}
 	}
+
+	for (int i = 0; i < (int)animEffToPlay.size(); i++)
+		indexEffect(i);
 }
 
 void EffectsManager::draw(sf::RenderWindow& win) {
-	for (const PlayingEffect& data : animEffToPlay)
+	const sf::View& v = win.getView();
+	sf::Vector2f size = v.getSize() + sf::Vector2f(cullMargin * 2.0f, cullMargin * 2.0f);
+	sf::FloatRect view(v.getCenter() - (size * 0.5f), size);
+
+	visIndex.query(view, visibleIds);
+	std::sort(visibleIds.begin(), visibleIds.end());
+	for (int i : visibleIds) {
+		const PlayingEffect& data = animEffToPlay[i];
 		win.draw(animEffects[data.type][data.index].sprite);
+	}
+	drawnCount = (int)visibleIds.size();
+	culledCount = (int)animEffToPlay.size() - drawnCount;
+	drawTracers(win);
+}
+
+void EffectsManager::playTracer(sf::Vector2f from, sf::Vector2f to) {
+	tracers.push_back({ from, to, tracerTime });
+}
+
+// swap-and-pop, the draw order of tracers does not matter
+void EffectsManager::updateTracers(double dt) {
+	for (int i = 0; i < (int)tracers.size();) {
+		tracers[i].timer -= (float)dt;
+		if (tracers[i].timer > 0.0f) {
+			i++;
+			continue;
+		}
+		tracers[i] = tracers.back();
+		tracers.pop_back();
+	}
+}
+
+// every tracer is a quad of one vertex array, drawn in a single call
+void EffectsManager::drawTracers(sf::RenderWindow& win) {
+	tracerVertices.resize(tracers.size() * 4);
+	for (int k = 0; k < (int)tracers.size(); k++) {
+		const Tracer& t = tracers[k];
+		sf::Vector2f d = t.to - t.from;
+		float len = std::sqrt(d.x * d.x + d.y * d.y);
+		sf::Vector2f n = (len > 0.0f) ? sf::Vector2f(-d.y, d.x) * (tracerWidth * 0.5f / len) : sf::Vector2f();
+		sf::Color c = tracerColor;
+		c.a = (sf::Uint8)(255.0f * std::clamp(t.timer / tracerTime, 0.0f, 1.0f));
+		sf::Vertex* quad = &tracerVertices[k * 4];
+		quad[0] = sf::Vertex(t.from - n, c);
+		quad[1] = sf::Vertex(t.to - n, c);
+		quad[2] = sf::Vertex(t.to + n, c);
+		quad[3] = sf::Vertex(t.from + n, c);
+	}
+	if (!tracers.empty()) win.draw(tracerVertices);
+}
+
+void EffectsManager::indexEffect(int playingIndex) {
+	const PlayingEffect& data = animEffToPlay[playingIndex];
+	visIndex.insert(playingIndex, animEffects[data.type][data.index].sprite.getGlobalBounds());
 }
 
 void EffectsManager::loadTextures() {
@@ -67,6 +127,7 @@ void EffectsManager::playAnimEffect(AnimEffectType type, sf::Vector2f pos, float
 			eff.sprite.setRotation(rot);
 			eff.sprite.setScale(scale);
 			animEffToPlay.push_back({ type, i });
+			indexEffect((int)animEffToPlay.size() - 1);
 			hasFound = true;
 			break;
 		}
@@ -74,10 +135,11 @@ void EffectsManager::playAnimEffect(AnimEffectType type, sf::Vector2f pos, float
 	if (hasFound) return;
 	AnimEffect data = animEffects[type][0];
 	AnimEffect newEff = AnimEffect(textures[type], data.frameSize, data.time);
-	animEffects[type].push_back(newEff);
 	newEff.sprite.setPosition(pos);
 	newEff.sprite.setRotation(rot);
 	newEff.sprite.setScale(scale);
 	newEff.isPlaying = true;
+	animEffects[type].push_back(newEff);
 	animEffToPlay.push_back({ type, (int)animEffects[type].size() - 1 });
+	indexEffect((int)animEffToPlay.size() - 1);
 }
\ No newline at end of file
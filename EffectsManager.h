@@ -7,6 +7,8 @@
 
 #include <SFML/Graphics.hpp>
 
+#include "SpatialHash.h"
+
 class EffectsManager
 {
 public:
@@ -21,6 +23,13 @@ public:
         int index;
     };
 
+    // hitscan shot line, fading out over tracerTime
+    struct Tracer {
+        sf::Vector2f from;
+        sf::Vector2f to;
+        float timer;
+    };
+
     struct AnimEffect {
         sf::Sprite sprite;
 		sf::Vector2i frameSize;
@@ -47,9 +56,20 @@ public:
 	std::map<AnimEffectType, sf::Texture> textures;
 	std::map<AnimEffectType, std::vector<AnimEffect>> animEffects;
     std::vector<PlayingEffect> animEffToPlay;
+    SpatialHash visIndex;
+    std::vector<int> visibleIds;
+    float cullMargin = 64.0f;
+    int drawnCount = 0;
+    int culledCount = 0;
     
     sf::Texture alertTex;
 
+    std::vector<Tracer> tracers;
+    sf::VertexArray tracerVertices{ sf::Quads };
+    float tracerTime = 0.06f;
+    float tracerWidth = 2.0f;
+    sf::Color tracerColor = { 255, 230, 160 };
+
 	EffectsManager();
     static EffectsManager& Instance() {
         static EffectsManager inst;
@@ -60,6 +80,10 @@ public:
 	void draw(sf::RenderWindow& win);
 	void loadTextures();
     void loadAnimations();
+	void indexEffect(int playingIndex);
 	void playAnimEffect(AnimEffectType type, sf::Vector2f pos, float rot = 0.0f, sf::Vector2f scale = { 1.0f, 1.0f });
+	void playTracer(sf::Vector2f from, sf::Vector2f to);
+	void updateTracers(double dt);
+	void drawTracers(sf::RenderWindow& win);
 };
 
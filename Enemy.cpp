@@ -8,7 +8,7 @@ Enemy::Enemy(sf::Vector2f pPos, WallMap& pWallMap, Player& pPlayer, const std::s
 {
 	isPlayer = false;
 	isGoingRight = randBool();
-	dxMax = 400.0f;
+	dxMax = RUN_SPEED;
 	dxRMax = 200.0f;
 	patrolSpeed = 175.0f;
 	brX = 2.0f;
@@ -28,7 +28,6 @@ Enemy::Enemy(sf::Vector2f pPos, WallMap& pWallMap, Player& pPlayer, const std::s
 	lookDownPos = pos + lookDownOffset;
 	alertSprite.setTexture(EffectsManager::Instance().alertTex);
 	alertSprite.setOrigin({10, 10});
-	bulletTex.loadFromFile("res/sprites/bullet.png");
 	weapOffset = { 0.0f, 12.0f };
 	weapScale = { 1.2f, 1.2f };
 	weapOrigin = { 27.0f, 15.0f };
@@ -42,21 +41,33 @@ Enemy::Enemy(sf::Vector2f pPos, WallMap& pWallMap, Player& pPlayer, const std::s
 }
 
 void Enemy::update(double dt) {
+	think(dt);
+	apply();
+}
+
+void Enemy::think(double dt) {
 	updateState();
 	updateSense();
 	updateLookDownPos();
 	doAction(dt);
 	updateAlertPos();
 	if (!isDead) updateWeapon(dt);
-	Entity::update(dt);
+}
+
+void Enemy::apply() {
+	if (!hasShot) return;
+	hasShot = false;
+	playShootEffect(shotPos, shotAngle);
+	generateBullet(shotPos, shotAngle);
+	applyRecoil(1500.0f, shotAngle);
 }
 
 void Enemy::draw(sf::RenderWindow& win) {
 	Entity::draw(win);
 	if (!isDead) {
-		weapon.draw(&win);
+		weapon.draw(&win, renderStates);
 		if (currentState == Attack || currentState == Chase)
-			win.draw(alertSprite);
+			win.draw(alertSprite, renderStates);
 	}
 }
 
@@ -67,6 +78,39 @@ void Enemy::setForEditorInstance() {
 	weapon.sprite.setPosition(targetPos);
 }
 
+// reuses a streamed out instance for a new spawn, without reloading its textures
+void Enemy::respawn(sf::Vector2f pPos) {
+	isStreamedOut = false;
+	isDead = false;
+	isTakingDamage = false;
+	isGrounded = false;
+	animSprite.sprite.setColor(sf::Color(255, 255, 255));
+	life = 3;
+	dx = 0.0f;
+	dy = 0.0f;
+	addedX = 0.0f;
+	addedY = 0.0f;
+	dmgTimer = 0.0;
+	currentState = Patrol;
+	hasSeenPlayer = false;
+	hasLosResult = false;
+	memoryTimer = 0.0;
+	reloadTimer = 0.0;
+	canShoot = false;
+	hasJustJump = false;
+	hasShot = false;
+	aiLod = LodFull;
+	lodTimer = 0.0;
+	wakeTimer = 0.0;
+	isGoingRight = randBool();
+	lastAimSense = (isGoingRight) ? 1 : -1;
+	startPos = pPos;
+	setPos(pPos.x, pPos.y);
+	setHitBoxes();
+	lookDownPos = pos + lookDownOffset;
+	setForEditorInstance();
+}
+
 void Enemy::loadAnimations() {
 	animSprite.addAnim(Idle, std::vector<unsigned int>{ 11, 12, 13, 14, 15 }, 0.5, true);
 	animSprite.addAnim(Run, std::vector<unsigned int>{ 17, 18, 19, 20, 21, 22, 23, 24 }, 0.45, true);
@@ -86,6 +130,8 @@ void Enemy::updateAlertPos() {
 void Enemy::updateLookDownPos() {
 	float dir = (currentState == Patrol) ? ((isGoingRight) ? 1.0f : -1.0f) : ((getSense() > 0) ? 1.0f : -1.0f);
 	lookDownPos = { pos.x + (lookDownOffset.x * dir), pos.y + lookDownOffset.y };
+	probeCell = { (int)(lookDownPos.x / C::GRID_SIZE), (int)(pos.y / C::GRID_SIZE) };
+	probeNav = wallMap.getNav(probeCell.x, probeCell.y);
 }
 
 void Enemy::updateState() {
@@ -134,13 +180,18 @@ void Enemy::doAction(double dt) {
 void Enemy::handleChase(double dt) {
 	if (!isGrounded && dy > 0) return;
 
-	if (!canSeePlayer()) {
+	bool isSeen = canSeePlayer();
+	if (!isSeen) {
 		memoryTimer += dt;
 		if (memoryTimer >= memoryTime) {
 			memoryTimer = 0.0;
 			hasSeenPlayer = false;
 			return;
 		}
+	}
+	if (followNavLink(dt)) return;
+
+	if (!isSeen) {
 		bool isRight = lastMemDir > 0 ? true : false;
 		moveX(dt, isRight, dxMax);
 		if (!canGoForward() && isGrounded && canJump()) {
@@ -154,6 +205,26 @@ void Enemy::handleChase(double dt) {
 	}
 }
 
+// Takes the next link of the chase flow out of the span under the enemy:
+// runs to its end, or to the take-off cell and jumps. False when already
+// on the player's span or with no route there, the direct chase does it.
+bool Enemy::followNavLink(double dt) {
+	if (!isGrounded) return false;
+	const NavGraph& nav = wallMap.nav;
+	sf::Vector2i cell = NavGraph::getStandingCell(vBox, (float)C::GRID_SIZE);
+	const NavGraph::Link* link = nav.getNextLink(nav.findNode(cell.x, cell.y));
+	if (link == nullptr) return false;
+
+	bool isTakeOff = link->type == NavGraph::Jump && cell.x == link->fromX;
+	bool isRight = (link->type == NavGraph::Jump && !isTakeOff) ? link->fromX > cell.x : link->dir > 0;
+	moveX(dt, isRight, dxMax);
+	if (isTakeOff) {
+		jump();
+		hasJustJump = true;
+	}
+	return true;
+}
+
 void Enemy::handleJump(double dt) {
 	if (isGrounded) {
 		hasJustJump = false;
@@ -256,9 +327,9 @@ void Enemy::shoot(double dt) {
 	if (!canShoot) return;
 	sf::Vector2f firePos = getFirePos();
 	weapon.playAnim(Shoot);
-	playShootEffect(firePos);
-	generateBullet(firePos);
-	applyRecoil(1500.0f, aimedAngle);
+	hasShot = true;
+	shotPos = firePos;
+	shotAngle = aimedAngle;
 	canShoot = false;
 	reloadTimer = 0.0f;
 }
@@ -270,13 +341,13 @@ sf::Vector2f Enemy::getFirePos() {
 	return firePos;
 }
 
-	void Enemy::playShootEffect(sf::Vector2f firePos) {
-		EffectsManager::Instance().playAnimEffect(EffectsManager::AnimEffectType::FireMuzzle, firePos, aimedAngle, { 4.0f, 4.0f });
+	void Enemy::playShootEffect(sf::Vector2f firePos, float angle) {
+		EffectsManager::Instance().playAnimEffect(EffectsManager::AnimEffectType::FireMuzzle, firePos, angle, { 4.0f, 4.0f });
 	}
 
-	void Enemy::generateBullet(sf::Vector2f firePos) {
-	Bullet newBullet(bulletTex, firePos, aimedAngle);
-	wallMap.bullets.push_back(newBullet);
+	void Enemy::generateBullet(sf::Vector2f firePos, float angle) {
+	if (wallMap.isEnemyHitscan) wallMap.fireHitscan(firePos, angle);
+	else wallMap.bullets.spawn(firePos, angle, BulletPool::EnemyOwner);
 }
 
 void Enemy::patrol(double dt) {
@@ -293,66 +364,42 @@ void Enemy::patrol(double dt) {
 		isGoingRight = !isGoingRight;
 }
 
+// the patrol probes all land around probeCell, so they are answered by the
+// nav neighbourhood read once per frame in updateLookDownPos
+bool Enemy::isProbeWall(int x, int y) {
+	int ox = x - probeCell.x;
+	int oy = y - probeCell.y;
+	if (ox < -1 || ox > 1 || oy < -1 || oy > 1) return wallMap.isWall(x, y);
+	return (probeNav & TileGrid::navBit(ox, oy)) != 0;
+}
+
 bool Enemy::isThereGround() {
 	int px = (int)(lookDownPos.x / C::GRID_SIZE);
 	int py = (int)(lookDownPos.y / C::GRID_SIZE);
-	return wallMap.isWall(px, py);
+	return isProbeWall(px, py);
 }
 
 bool Enemy::canGoForward() {
 	float dir = (getSense() > 0) ? 40.0f : -40.0f;
 	int px = (int)((lookDownPos.x + dir) / C::GRID_SIZE);
 	int py = (int)((pos.y) / C::GRID_SIZE);
-	return !wallMap.isWall(px, py);
+	return !isProbeWall(px, py);
 }
 
 bool Enemy::canJump() {
 	int px = (int)(lookDownPos.x / C::GRID_SIZE);
 	int py = (int)((pos.y - C::GRID_SIZE) / C::GRID_SIZE);
-	return !wallMap.isWall(px, py);
+	return !isProbeWall(px, py);
 }
 
 bool Enemy::canSeePlayer() {
-	int startX = int(pos.x / C::GRID_SIZE);
-	int startY = int(pos.y / C::GRID_SIZE);
-	int endX = int(player.pos.x / C::GRID_SIZE);
-	int endY = int(player.pos.y / C::GRID_SIZE);
-	int x0 = startX;
-	int y0 = startY;
-	int x1 = endX;
-	int y1 = endY;
-
-	bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
-	if (steep) {
-		std::swap(x0, y0);
-		std::swap(x1, y1);
-	}
-
-	if (x0 > x1) {
-		std::swap(x0, x1);
-		std::swap(y0, y1);
-	}
-
-	const int dx = x1 - x0;
-	const int dy = std::abs(y1 - y0);
-	int err = dx / 2;
-	int y = y0;
-	const int yStep = (y0 < y1) ? 1 : -1;
-
-	for (int x = x0; x <= x1; ++x)
-	{
-		const int cellX = steep ? y : x;
-		const int cellY = steep ? x : y;
-
-		if ((cellX != startX || cellY != startY) && wallMap.isWall(cellX, cellY))
-			return false;
-
-		err -= dy;
-		if (err < 0) {
-			y += yStep;
-			err += dx;
-		}
+	bool isVisible = losResult;
+	if (!hasLosResult) {
+		sf::Vector2f d = player.pos - pos;
+		float len = std::sqrt(d.x * d.x + d.y * d.y);
+		isVisible = !wallMap.raycast(pos, normalize(d), len, true).hit;
 	}
+	if (!isVisible) return false;
 
 	memoryTimer = 0.0;
 	lastMemDir = (pos.x - player.pos.x < 0) ? 1 : -1 ;
@@ -20,16 +20,31 @@ public:
 		Shoot
 	};
 
+	// AI level of detail, picked by WallMap::scheduleEnemies
+	enum AiLod {
+		LodFull,
+		LodReduced,
+		LodAsleep
+	};
+
+	static constexpr float RUN_SPEED = 400.0f;
+
 	Player& player;
 	sf::Sprite alertSprite;
 	ActionState currentState;
 	sf::Vector2f startPos;
 	sf::Vector2f lookDownOffset;
 	sf::Vector2f lookDownPos;
+	sf::Vector2i probeCell;
+	uint16_t probeNav = 0;
 	float viewDistance = 800.0f;
 	float patrolDistance = 600.0f;
 	float patrolSpeed;
 	bool hasSeenPlayer = false;
+	bool hasLosResult = false;
+	bool losResult = false;
+	bool isStreamedOut = false;
+	int spawnId = -1;
 	bool isGoingRight;
 
 	double memoryTimer = 0.0;
@@ -42,7 +57,6 @@ public:
 	sf::Vector2f weapOrigin;
 	sf::Vector2f weapOffset;
 	sf::Vector2f targetPos;
-	sf::Texture bulletTex;
 	double reloadTime = 0.5f;
 	double reloadTimer = 0.0f;
 	float aimedAngle = 0.0f;
@@ -51,15 +65,28 @@ public:
 	int lastAimSense;
 	bool canShoot = false;
 	bool hasJustJump = false;
+	bool hasShot = false;
+	sf::Vector2f shotPos;
+	float shotAngle = 0.0f;
+
+	AiLod aiLod = LodFull;
+	double lodTimer = 0.0;
+	double wakeTimer = 0.0;
+	double thinkDt = 0.0;
 
 	Enemy(sf::Vector2f pPos, WallMap& pWallMap, Player& pPlayer, const std::string& spritePath, sf::Vector2i frameSize);
+	// AI and weapon only, WallMap runs the physics of all enemies in a batch
 	void update(double dt) override;
+	// think only writes this enemy, apply does what a shot does to the world
+	void think(double dt);
+	void apply();
 	void draw(sf::RenderWindow& win) override;
 	void loadAnimations();
 	void updateState();
 	void doAction(double dt);
 	void updateSense();
 	void setForEditorInstance();
+	void respawn(sf::Vector2f pPos);
 	void updateAlertPos();
 
 	void updateWeapon(double dt);
@@ -71,13 +98,15 @@ public:
 	void shoot(double dt);
 	void updateShootTimer(double dt);
 	sf::Vector2f getFirePos();
-	void playShootEffect(sf::Vector2f firePos);
-	void generateBullet(sf::Vector2f pPos);
+	void playShootEffect(sf::Vector2f firePos, float angle);
+	void generateBullet(sf::Vector2f pPos, float angle);
 	void patrol(double dt);
+	bool isProbeWall(int x, int y);
 	bool isThereGround();
 	bool canGoForward();
 	bool canSeePlayer();
 	void handleChase(double dt);
+	bool followNavLink(double dt);
 	void handleJump(double dt);
 	bool canJump();
 };
@@ -7,7 +7,22 @@ Entity::Entity(WallMap& pWallMap, const std::string& spritePath, sf::Vector2i fr
 {
 	pos = sf::Vector2f{};
 	dyMax = 1000.0f;
-	accY = 1000.0f;
+	accY = ACC_Y;
+	dx = 0.0f;
+	dy = 0.0f;
+	speedX = 0.0f;
+	speedY = 0.0f;
+	addedX = 0.0f;
+	addedY = 0.0f;
+}
+
+Entity::Entity(WallMap& pWallMap, const sf::Texture& texture, sf::Vector2i frameSize)
+	: animSprite(texture, frameSize),
+	wallMap(pWallMap)
+{
+	pos = sf::Vector2f{};
+	dyMax = 1000.0f;
+	accY = ACC_Y;
 	dx = 0.0f;
 	dy = 0.0f;
 	speedX = 0.0f;
@@ -17,18 +32,27 @@ Entity::Entity(WallMap& pWallMap, const std::string& spritePath, sf::Vector2i fr
 }
 
 void Entity::update(double dt) {
+	updatePhysics(dt);
+	updateAfterPhysics(dt);
+}
+
+// per-object path, PhysicsWorld runs the same stages over whole batches
+void Entity::updatePhysics(double dt) {
 	if (!isGrounded)
 		applyGravity(dt);
 	handleAddedMovement(dt);
 	handleCollisions(dt);
 	setMove(dt);
-	handleAnimations(dt);
 	slowAddedMovement(dt);
+}
+
+void Entity::updateAfterPhysics(double dt) {
+	handleAnimations(dt);
 	handleDmgFeedback(dt);
 }
 
 void Entity::draw(sf::RenderWindow& win) {
-	animSprite.draw(&win);
+	animSprite.draw(&win, renderStates);
 	if (C::IS_DEBUG) drawHitBoxes(win);
 }
 
@@ -37,11 +61,24 @@ void Entity::setPos(float x, float y) {
 	setPos(pos);
 }
 
+// teleports, so there is nothing to interpolate from
 void Entity::setPos(sf::Vector2f pPos) {
 	pos = pPos;
+	prevPos = pPos;
 	animSprite.sprite.setPosition(pPos);
 }
 
+// called at the start of each simulation tick
+void Entity::savePrevPos() {
+	prevPos = pos;
+}
+
+// the sprites stay at pos, the draw is offset back toward prevPos
+void Entity::setRenderAlpha(float alpha) {
+	renderStates.transform = sf::Transform::Identity;
+	renderStates.transform.translate((prevPos - pos) * (1.0f - alpha));
+}
+
 void Entity::setHitBoxes() {
 	sf::Vector2f orgn = animSprite.sprite.getOrigin();
 	sf::Vector2f scaledOrgn = { orgn.x * scale.x, orgn.y * scale.y };
@@ -93,45 +130,31 @@ void Entity::applyGravity(double dt) {
 		dy = dyMax;
 }
 
+// Sweeps the hitbox vertically, then horizontally from where the vertical
+// move ends, and stops each axis at its time of impact. Nothing tunnels
+// through a tile however long the step is.
 void Entity::handleCollisions(double dt) {
-	updateHitBoxes(dt);
-
-	bool vCollide = false;
-	bool hCollide = false;
-
-	int vX0 = (int)(vBox.left / C::GRID_SIZE);
-	int vX1 = (int)((vBox.left + vBox.width - C::EPS) / C::GRID_SIZE);
-	int vY0 = (int)((vBox.top + C::EPS) / C::GRID_SIZE);
-	int vY1 = (int)((vBox.top + vBox.height) / C::GRID_SIZE);
-
-	int hX0 = (int)(hBox.left / C::GRID_SIZE);
-	int hX1 = (int)((hBox.left + hBox.width) / C::GRID_SIZE);
-	int hY0 = (int)((hBox.top + C::EPS) / C::GRID_SIZE);
-	int hY1 = (int)((hBox.top + hBox.height - C::EPS) / C::GRID_SIZE);
-
-
-	for (int i = vX0; i <= vX1; i++)
-		if ((speedY > 0.0f && wallMap.isWall(i, vY1)) || (speedY < 0.0f && wallMap.isWall(i, vY0))) {
-			vCollide = true;
-			break;
-		}
-	for (int i = hY0; i <= hY1; i++)
-	for (int i = hY0; i <= hY1; i++)
-		if ((speedX > 0.0f && wallMap.isWall(hX1, i)) || (speedX < 0.0f && wallMap.isWall(hX0, i))) {
-			hCollide = true;
-			break;
-		}
+	sf::Vector2f orgn = animSprite.sprite.getOrigin();
+	float left = pos.x - orgn.x * scale.x + leftPaddingBox;
+	float top = pos.y - orgn.y * scale.y + topPaddingBox;
+	float distX = (float)(speedX * dt);
+	float distY = (float)(speedY * dt);
+	PhysicsWorld::Sweep vHit = PhysicsWorld::sweepY(wallMap.tileGrid, left, top, vBox.width, vBox.height, distY);
+	float moveY = distY * vHit.time;
+	PhysicsWorld::Sweep hHit = PhysicsWorld::sweepX(wallMap.tileGrid, left, top + moveY, hBox.width, hBox.height, distX);
 
 	isGrounded = false;
 	double dy0 = speedY;
 
-	if (vCollide) {
-		if (speedY > 0.0f) isGrounded = true; else isGrounded = false;
+	if (vHit.normal != 0) {
+		isGrounded = vHit.normal < 0;
+		pos.y += moveY;
 		dy = 0.0f;
 		speedY = 0.0f;
 	}
 
-	if (hCollide) {
+	if (hHit.normal != 0) {
+		pos.x += distX * hHit.time;
 		dx = 0.0f;
 		speedX = 0.0f;
 	}
@@ -155,14 +178,12 @@ void Entity::checkGround(double dy0) {
 	int x0 = (int)(hBox.left / C::GRID_SIZE);
 	int x1 = (int)((hBox.left + hBox.width - C::EPS) / C::GRID_SIZE);
 	int gY = (int)((hBox.top + hBox.height + 1.0f) / C::GRID_SIZE);
-	isGrounded = false;
-	for (int i = x0; i <= x1; i++)
-		if (wallMap.isWall(i, gY)) { isGrounded = true; break; }
+	isGrounded = wallMap.anyWallInRow(gY, x0, x1);
 }
 
 void Entity::jump() {
 	if (!isGrounded) return;
-	dy = (isPlayer) ? -1000.0f : -700.0f;
+	dy = (isPlayer) ? -PLAYER_JUMP_SPEED : -ENEMY_JUMP_SPEED;
 	isGrounded = false;
 	justJump = true;
 }
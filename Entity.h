@@ -26,6 +26,8 @@ public:
 	AnimatedSprite<AnimType> animSprite;
 	WallMap& wallMap;
 	sf::Vector2f pos;
+	sf::Vector2f prevPos;
+	sf::RenderStates renderStates;
 	sf::Vector2f scale;
 	sf::Vector2f renderSize;
 	sf::FloatRect vBox;
@@ -46,6 +48,10 @@ public:
 	float brX;
 	float accY;
 	bool isPlayer;
+
+	static constexpr float ACC_Y = 1000.0f;
+	static constexpr float PLAYER_JUMP_SPEED = 1000.0f;
+	static constexpr float ENEMY_JUMP_SPEED = 700.0f;
 	bool isGrounded;
 	bool justJump;
 
@@ -56,10 +62,15 @@ public:
 	bool isTakingDamage;
 
 	Entity(WallMap& pWallMap, const std::string& spritePath, sf::Vector2i frameSize);
+	Entity(WallMap& pWallMap, const sf::Texture& texture, sf::Vector2i frameSize);
 	virtual void update(double dt);
+	void updatePhysics(double dt);
+	void updateAfterPhysics(double dt);
 	virtual void draw(sf::RenderWindow& win);
 	void setPos(float x, float y);
 	void setPos(sf::Vector2f pPos);
+	void savePrevPos();
+	void setRenderAlpha(float alpha);
 	void setHitBoxes();
 	void handleAddedMovement(double dt);
 	void slowAddedMovement(double dt);
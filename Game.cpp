@@ -1,4 +1,5 @@
 #include "Game.hpp"
+#include "Lib.hpp"
 
 Game::Game(sf::RenderWindow& pWin)
 	: win(pWin),
@@ -7,23 +8,180 @@ Game::Game(sf::RenderWindow& pWin)
 	player(wallMap, "res/sprites/player.png", { 67, 48 }, pointer)
 {
 	loadEditTextures();
+	player.setForEditorInstance(wallMap.playerStart);
 }
 
+// Fixed step: the frame time feeds an accumulator drained in 1 / tickRate
+// ticks, at most maxTicksPerFrame per frame, anything past that is dropped
+// (and counted) instead of spiralling. The leftover fraction of a tick is
+// the render alpha between the previous and the current state.
 void Game::update(double dt) {
 	if (inEditor) {
+		// no tick runs in the editor, its edits are committed per frame
+		wallMap.changes.commit();
 		handleEditorUpdate();
 		return;
 	}
-	dt = std::min(dt, 1.0/30.0);
+
+	// a replay runs at the rate it was recorded with
+	if (input.mode == Input::Replaying) {
+		isFixedStep = true;
+		tickRate = (int)input.tickRate;
+	}
+
+	double start = Lib::getTimeStamp();
+	if (isFixedStep) {
+		double tick = 1.0 / tickRate;
+		double maxLag = tick * maxTicksPerFrame;
+		accumulator += dt;
+		if (accumulator > maxLag) {
+			droppedTime += accumulator - maxLag;
+			accumulator = maxLag;
+		}
+		frameTicks = 0;
+		while (accumulator >= tick) {
+			if (input.mode == Input::Replaying && input.isReplayOver()) {
+				finishReplay();
+				accumulator = 0.0;
+				break;
+			}
+			step(tick);
+			accumulator -= tick;
+			frameTicks++;
+		}
+		renderAlpha = (float)(accumulator / tick);
+	}
+	else {
+		step(std::min(dt, 1.0 / 30.0));
+		frameTicks = 1;
+		renderAlpha = 1.0f;
+	}
+	wallMap.renderAlpha = renderAlpha;
+
+	if (frameTicks > 0) tickCost = (Lib::getTimeStamp() - start) / frameTicks;
+	tpsTicks += frameTicks;
+	tpsTimer += dt;
+	if (tpsTimer >= 1.0) {
+		ticksPerSecond = tpsTicks / tpsTimer;
+		tpsTicks = 0;
+		tpsTimer = 0.0;
+	}
+}
+
+// Everything the tick reads from the devices comes through input, so a
+// recording played from the same start goes through the same states.
+void Game::step(double dt) {
+	input.beginTick(win);
+	player.input = input.current;
+	pointer.update(input.current);
+	player.savePrevPos();
+	wallMap.savePrevState();
 	player.update(dt);
-	pointer.update(dt);
 	EffectsManager::Instance().update(dt);
 	wallMap.update(dt);
 }
 
+// Puts the simulation in a state that only depends on the level file and
+// the seed. The level is reloaded from disk, unsaved edits are lost.
+bool Game::restart(uint32_t seed) {
+	seedRandom(seed);
+	if (!wallMap.loadLevel(wallMap.levelPath)) return false;
+	sf::Vector2f center = win.getDefaultView().getCenter();
+	wallMap.camera.setCenter(center);
+	wallMap.prevCameraCenter = center;
+	wallMap.shakeTimer = 0.0;
+	wallMap.losCache.clear();
+	win.setView(wallMap.camera);
+	player.respawn(wallMap.playerStart);
+	pointer.update(InputState());
+	accumulator = 0.0;
+	return true;
+}
+
+void Game::startRecording() {
+	uint32_t seed = std::random_device{}();
+	if (!restart(seed)) return;
+	isFixedStep = true;
+	wallMap.isStreamingBlocking = true;
+	input.startRecording((uint32_t)tickRate, seed);
+}
+
+void Game::stopRecording() {
+	input.stopRecording(wallMap.getStateChecksum());
+	wallMap.isStreamingBlocking = false;
+	input.save(replayPath);
+}
+
+bool Game::startReplay() {
+	if (!input.load(replayPath) || !restart(input.seed)) return false;
+	wallMap.isStreamingBlocking = true;
+	input.startReplay();
+	return true;
+}
+
+// the state after the last tick has to match the one recorded, a replay
+// stopped early is not checked
+void Game::finishReplay() {
+	if (input.isReplayOver()) Bench::addCheck("Replay checksum", (wallMap.getStateChecksum() == input.checksum) ? 0 : 1, 1);
+	input.stopReplay();
+	wallMap.isStreamingBlocking = false;
+}
+
+// Runs the whole recording in one call, without drawing, to measure the
+// simulation alone.
+void Game::runHeadlessReplay() {
+	if (!startReplay()) return;
+	double tick = 1.0 / input.tickRate;
+	double start = Lib::getTimeStamp();
+	while (!input.isReplayOver()) step(tick);
+	Bench::addResult("Replay headless", Lib::getTimeStamp() - start, (double)input.ticks.size(), "Mticks/s");
+	finishReplay();
+}
+
+// Plays the same scripted ticks from the same seed with no job worker and
+// with one per core, one enemy per think range, and compares the state
+// checksums: the enemy update must not depend on the thread count. The
+// level is left restarted.
+void Game::checkThreadDeterminism() {
+	const int ticks = 600;
+	const uint32_t seed = 1;
+	const int workers[2] = { 0, std::max(1, (int)std::thread::hardware_concurrency()) };
+	int workerCount = wallMap.jobs.getWorkerCount();
+	int grain = wallMap.thinkGrain;
+	Input live = input;
+
+	// runs right then left, firing, jumping now and then
+	std::vector<InputState> script(ticks);
+	for (int t = 0; t < ticks; t++) {
+		bool isRight = (t / 90) % 2 == 0;
+		script[t].buttons = InputState::Fire | (isRight ? InputState::Right : InputState::Left);
+		if (t % 45 == 0) script[t].buttons |= InputState::Jump;
+		script[t].aim = wallMap.playerStart + sf::Vector2f(isRight ? 600.0f : -600.0f, (float)(t % 60) - 30.0f);
+	}
+
+	uint64_t checksums[2] = {};
+	bool isRun = true;
+	wallMap.thinkGrain = 1;
+	for (int k = 0; k < 2 && isRun; k++) {
+		wallMap.jobs.start(workers[k]);
+		isRun = restart(seed);
+		wallMap.isStreamingBlocking = true;
+		input.ticks = script;
+		input.startReplay();
+		for (int t = 0; t < ticks && isRun; t++) step(1.0 / tickRate);
+		checksums[k] = wallMap.getStateChecksum();
+	}
+	input = live;
+	wallMap.isStreamingBlocking = false;
+	wallMap.thinkGrain = grain;
+	wallMap.jobs.start(workerCount);
+	if (isRun) Bench::addCheck("Thread count determinism", (checksums[0] == checksums[1]) ? 0 : 1, 1);
+}
+
  void Game::draw(sf::RenderWindow & win) {
 	if (closing) return;
 	wallMap.draw();
+	player.setRenderAlpha(renderAlpha);
 	player.draw(win);
 	pointer.draw();
 	EffectsManager::Instance().draw(win);
@@ -33,8 +191,102 @@ void Game::update(double dt) {
  // ============================================== EDITOR
 
 void Game::im() {
+	if (ImGui::CollapsingHeader("Render Stats", ImGuiTreeNodeFlags_::ImGuiTreeNodeFlags_DefaultOpen)) {
+		ImGui::Value("Wall chunks", (int)wallMap.chunkMeshes.size());
+		ImGui::Value("Wall draw calls", wallMap.wallDrawCalls);
+		ImGui::Value("Wall chunks culled", wallMap.renderStats.wallChunksCulled);
+		ImGui::Value("Enemies drawn", wallMap.renderStats.enemiesDrawn);
+		ImGui::Value("Enemies culled", wallMap.renderStats.enemiesCulled);
+		ImGui::Value("Bullets drawn", wallMap.renderStats.bulletsDrawn);
+		ImGui::Value("Bullets culled", wallMap.renderStats.bulletsCulled);
+		ImGui::Value("Bullet draw calls", wallMap.renderStats.bulletDrawCalls);
+		ImGui::Value("Live bullets", wallMap.bullets.size());
+		ImGui::Value("Dropped bullets", wallMap.bullets.dropped);
+		ImGui::Value("Effects drawn", EffectsManager::Instance().drawnCount);
+		ImGui::Value("Effects culled", EffectsManager::Instance().culledCount);
+		ImGui::Value("Resident chunks", wallMap.renderStats.residentChunks);
+		ImGui::Value("Queued chunks", wallMap.renderStats.queuedChunks);
+		ImGui::Value("Parked enemies", wallMap.renderStats.parkedEnemies);
+		ImGui::Value("Map version", wallMap.changes.version);
+		ImGui::Value("Logged changes", (int)wallMap.changes.changes.size());
+	}
+	if (ImGui::CollapsingHeader("Navigation")) {
+		ImGui::Value("Spans", wallMap.nav.aliveNodes);
+		ImGui::Value("Links", wallMap.nav.linkCount);
+		ImGui::Value("Jump rows", wallMap.nav.jumpRows);
+		ImGui::Value("Player span", wallMap.playerNavNode);
+		ImGui::LabelText("Last rebuild", "%0.3f ms", wallMap.nav.lastBuildTime * 1000.0);
+	}
+	if (ImGui::CollapsingHeader("Weapons")) {
+		ImGui::Checkbox("Player hitscan", &player.weapon.isHitscan);
+		ImGui::Checkbox("Enemy hitscan", &wallMap.isEnemyHitscan);
+		ImGui::SliderFloat("Player reload time", &player.weapon.reloadTime, 0.01f, 0.5f);
+		ImGui::SliderFloat("Hitscan range", &wallMap.hitscanRange, 100.0f, 4000.0f);
+		ImGui::Value("Hitscan shots last tick", wallMap.hitscanShotsLastTick);
+		ImGui::Value("Live tracers", (int)EffectsManager::Instance().tracers.size());
+	}
+	if (ImGui::CollapsingHeader("Line of sight")) {
+		ImGui::Checkbox("LOS cache", &wallMap.isLosCacheEnabled);
+		ImGui::LabelText("Hit rate", "%0.1f %%", wallMap.losCache.getHitRate() * 100.0f);
+		ImGui::LabelText("Hits / raycasts this tick", "%d / %d", wallMap.losCache.tickHits, (int)wallMap.losRays.size());
+		ImGui::Value("Cached lines", (int)wallMap.losCache.entries.size());
+		ImGui::Value("Invalidated", (int)wallMap.losCache.invalidated);
+		if (ImGui::Button("Reset LOS stats")) {
+			wallMap.losCache.hits = 0;
+			wallMap.losCache.misses = 0;
+			wallMap.losCache.invalidated = 0;
+		}
+	}
+	if (ImGui::CollapsingHeader("Simulation", ImGuiTreeNodeFlags_::ImGuiTreeNodeFlags_DefaultOpen)) {
+		ImGui::Checkbox("Fixed step", &isFixedStep);
+		ImGui::SliderInt("Tick rate", &tickRate, 15, 240);
+		ImGui::SliderInt("Max ticks per frame", &maxTicksPerFrame, 1, 16);
+		ImGui::Value("Ticks this frame", frameTicks);
+		ImGui::Value("Render alpha", renderAlpha);
+		ImGui::LabelText("Ticks/s", "%0.1f", ticksPerSecond);
+		ImGui::LabelText("Tick cost", "%0.3f ms (%0.0f ticks/s max)", tickCost * 1000.0, (tickCost > 0.0) ? 1.0 / tickCost : 0.0);
+		ImGui::LabelText("Dropped time", "%0.3f s", droppedTime);
+		int workers = wallMap.jobs.getWorkerCount();
+		if (ImGui::SliderInt("Job workers", &workers, 0, 31)) wallMap.jobs.start(workers);
+		ImGui::SliderInt("Think grain", &wallMap.thinkGrain, 1, 1024);
+		ImGui::LabelText("Enemy think", "%0.3f ms", wallMap.thinkTime * 1000.0);
+		ImGui::Checkbox("AI LOD", &wallMap.isAiLodEnabled);
+		ImGui::SliderFloat("AI full radius", &wallMap.aiFullRadius, 0.0f, 10000.0f);
+		ImGui::SliderFloat("AI sleep radius", &wallMap.aiSleepRadius, 0.0f, 20000.0f);
+		ImGui::SliderFloat("AI reduced step", &wallMap.aiReducedStep, 0.0f, 1.0f);
+		ImGui::LabelText("AI full / reduced / asleep", "%d / %d / %d", wallMap.aiLodStats.full, wallMap.aiLodStats.reduced, wallMap.aiLodStats.asleep);
+		ImGui::Value("AI thinking this tick", wallMap.aiLodStats.thinking);
+		ImGui::Checkbox("SIMD physics", &wallMap.physics.useSimd);
+		ImGui::SameLine();
+		ImGui::Text("(%s)", PhysicsWorld::getSimdName());
+	}
+	if (ImGui::CollapsingHeader("Replay") && !inEditor) {
+		if (input.mode == Input::Live) {
+			if (ImGui::Button("Record")) startRecording();
+			ImGui::SameLine();
+			if (ImGui::Button("Replay")) startReplay();
+			ImGui::SameLine();
+			if (ImGui::Button("Headless replay")) runHeadlessReplay();
+			ImGui::SameLine();
+			if (ImGui::Button("Thread determinism")) checkThreadDeterminism();
+		}
+		else if (ImGui::Button("Stop")) {
+			if (input.mode == Input::Recording) stopRecording();
+			else finishReplay();
+		}
+		ImGui::Text("%s", replayPath.c_str());
+		if (input.mode == Input::Replaying)
+			ImGui::LabelText("Replay tick", "%d / %d", input.replayTick, (int)input.ticks.size());
+		else
+			ImGui::Value("Recorded ticks", (int)input.ticks.size());
+		ImGui::Value("Tick rate", (int)input.tickRate);
+	}
+	Bench::im(wallMap);
+
 	if (!inEditor) {
 		if (ImGui::Button("Editor")) {
+			if (input.mode == Input::Recording) stopRecording();
+			else if (input.mode == Input::Replaying) finishReplay();
 			editorSprite.setTexture(editTextures[editMode]);
 			inEditor = true;
 			player.isGameInEditor = true;
@@ -50,6 +302,12 @@ void Game::im() {
 		editMode = EditMode::Box;
 	}
 
+	if (ImGui::Button("Save Level"))
+		wallMap.saveLevel(wallMap.levelPath);
+	ImGui::SameLine();
+	if (ImGui::Button("Load Level") && wallMap.loadLevel(wallMap.levelPath))
+		player.setForEditorInstance(wallMap.playerStart);
+
 	if (ImGui::Button("Box")) {
 		editMode = EditMode::Box;
 		editorSprite.setTexture(editTextures[editMode]);
@@ -141,8 +399,13 @@ void Game::handleEditorUpdate() {
 					break;
 				}
 
-		if (canDrop)
-			for (Enemy& e : wallMap.enemies) {
+		if (canDrop) {
+			// 1 px of margin catches hitboxes ending exactly on the cell edge
+			sf::FloatRect cell = { sprtX - 1.0f, sprtY - 1.0f, C::GRID_SIZE + 2.0f, C::GRID_SIZE + 2.0f };
+			wallMap.enemyIndex.query(cell, wallMap.queryIds);
+			for (int i : wallMap.queryIds) {
+				Enemy& e = wallMap.enemies[i];
+				if (e.isStreamedOut) continue;
 				for (sf::Vector2i v : e.getVHitboxCells())
 					if (v.x == cx && v.y == cy) {
 						canDrop = false;
@@ -150,6 +413,7 @@ void Game::handleEditorUpdate() {
 					}
 				if (!canDrop) break;
 			}
+		}
 	}
 	else
 	{
@@ -159,7 +423,7 @@ void Game::handleEditorUpdate() {
 
 		if (editMode == EditMode::Enemy) {
 			editorSprite.setOrigin({ 21.0f, 21.0f });
-			rect = wallMap.enemies[0].vBox;
+			rect = wallMap.enemies.empty() ? player.vBox : wallMap.enemies[0].vBox;
 		}
 		else {
 			editorSprite.setOrigin({ 33.0f, 24.0f });
@@ -185,9 +449,21 @@ void Game::handleEditorUpdate() {
 				if (!canDrop) break;
 			}
 
-		if (canDrop)
+		if (canDrop && !cellsToCheck.empty()) {
+			sf::Vector2i lo = cellsToCheck.front();
+			sf::Vector2i hi = cellsToCheck.front();
+			for (sf::Vector2i cell : cellsToCheck) {
+				lo = { std::min(lo.x, cell.x), std::min(lo.y, cell.y) };
+				hi = { std::max(hi.x, cell.x), std::max(hi.y, cell.y) };
+			}
+			sf::FloatRect area = { lo.x * C::GRID_SIZE - 1.0f, lo.y * C::GRID_SIZE - 1.0f,
+				(hi.x - lo.x + 1) * C::GRID_SIZE + 2.0f, (hi.y - lo.y + 1) * C::GRID_SIZE + 2.0f };
+			wallMap.enemyIndex.query(area, wallMap.queryIds);
+
 			for (sf::Vector2i cell : cellsToCheck) {
-				for (Enemy& e : wallMap.enemies) {
+				for (int i : wallMap.queryIds) {
+					Enemy& e = wallMap.enemies[i];
+					if (e.isStreamedOut) continue;
 					for (sf::Vector2i v : e.getVHitboxCells())
 						if (cell.x == v.x && cell.y == v.y) {
 							canDrop = false;
@@ -196,7 +472,8 @@ void Game::handleEditorUpdate() {
 					if (!canDrop) break;
 				}
 				if (!canDrop) break;
-			}	
+			}
+		}
 	}
 
 	if (canDrop)
@@ -18,6 +18,8 @@
 #include "WallMap.h"
 #include "Pointer.h"
 #include "EffectsManager.h"
+#include "Bench.h"
+#include "Input.h"
 
 class HotReloadShader;
 
@@ -50,10 +52,33 @@ public:
 	sf::Sprite editorSprite;
 	sf::Vector2f mousePosWorld;
 
+	bool isFixedStep = true;
+	int tickRate = 120;
+	int maxTicksPerFrame = 8;
+	double accumulator = 0.0;
+	float renderAlpha = 1.0f;
+	int frameTicks = 0;
+	double droppedTime = 0.0;
+	double tickCost = 0.0;
+	double ticksPerSecond = 0.0;
+	double tpsTimer = 0.0;
+	int tpsTicks = 0;
+
+	Input input;
+	std::string replayPath = "replay.enjr";
+
 
 	Game(sf::RenderWindow& win);
 	void update(double dt);
+	void step(double dt);
 	void draw(sf::RenderWindow& win);
+	bool restart(uint32_t seed);
+	void startRecording();
+	void stopRecording();
+	bool startReplay();
+	void finishReplay();
+	void runHeadlessReplay();
+	void checkThreadDeterminism();
 
 	void im();
 	void loadEditTextures();
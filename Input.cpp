@@ -0,0 +1,121 @@
+#include <fstream>
+#include <iostream>
+
+#include "Input.h"
+
+// the aim uses the view set by the last tick, as Pointer always did
+InputState Input::poll(const sf::RenderWindow& win) {
+	InputState s;
+	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q)) s.buttons |= InputState::Left;
+	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) s.buttons |= InputState::Right;
+	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Space)) s.buttons |= InputState::Jump;
+	if (sf::Mouse::isButtonPressed(sf::Mouse::Left)) s.buttons |= InputState::Fire;
+	s.aim = win.mapPixelToCoords(sf::Mouse::getPosition(win));
+	return s;
+}
+
+void Input::beginTick(const sf::RenderWindow& win) {
+	if (mode == Replaying) {
+		current = isReplayOver() ? InputState() : ticks[replayTick++];
+		return;
+	}
+	current = poll(win);
+	if (mode == Recording) ticks.push_back(current);
+}
+
+void Input::startRecording(uint32_t pTickRate, uint32_t pSeed) {
+	mode = Recording;
+	tickRate = pTickRate;
+	seed = pSeed;
+	checksum = 0;
+	ticks.clear();
+}
+
+void Input::stopRecording(uint64_t pChecksum) {
+	mode = Live;
+	checksum = pChecksum;
+}
+
+void Input::startReplay() {
+	mode = Replaying;
+	replayTick = 0;
+}
+
+void Input::stopReplay() {
+	mode = Live;
+	current = InputState();
+}
+
+bool Input::save(const std::string& path) const {
+	std::vector<Run> runs;
+	for (const InputState& s : ticks) {
+		Run* last = runs.empty() ? nullptr : &runs.back();
+		if (last && last->count < UINT16_MAX && last->buttons == s.buttons && last->aimX == s.aim.x && last->aimY == s.aim.y)
+			last->count++;
+		else
+			runs.push_back({ 1, s.buttons, 0, s.aim.x, s.aim.y });
+	}
+
+	Header h{ MAGIC, VERSION, tickRate, seed, (uint32_t)ticks.size(), (uint32_t)runs.size(), checksum };
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "REPLAY SAVE ERROR, path : " << path << std::endl;
+		return false;
+	}
+	out.write((const char*)&h, sizeof(Header));
+	out.write((const char*)runs.data(), runs.size() * sizeof(Run));
+	return (bool)out;
+}
+
+bool Input::load(const std::string& path) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	size_t size = in ? (size_t)in.tellg() : 0;
+	in.seekg(0);
+	Header h{};
+	if (size < sizeof(Header) || !in.read((char*)&h, sizeof(Header)) || h.magic != MAGIC || h.version != VERSION) {
+		std::cout << "REPLAY LOAD ERROR, path : " << path << std::endl;
+		return false;
+	}
+
+	// sizes are checked against the file before anything is allocated:
+	// every run holds 1 to UINT16_MAX ticks
+	if (size != sizeof(Header) + (size_t)h.runCount * sizeof(Run) || h.runCount > h.tickCount
+		|| (uint64_t)h.tickCount > (uint64_t)h.runCount * UINT16_MAX) {
+		std::cout << "REPLAY LOAD ERROR, bad size : " << path << std::endl;
+		return false;
+	}
+
+	std::vector<Run> runs(h.runCount);
+	if (!in.read((char*)runs.data(), runs.size() * sizeof(Run))) {
+		std::cout << "REPLAY LOAD ERROR, truncated : " << path << std::endl;
+		return false;
+	}
+
+	uint64_t total = 0;
+	bool hasEmptyRun = false;
+	for (const Run& r : runs) {
+		total += r.count;
+		hasEmptyRun |= r.count == 0;
+	}
+	if (hasEmptyRun || total != h.tickCount) {
+		std::cout << "REPLAY LOAD ERROR, tick count : " << path << std::endl;
+		return false;
+	}
+
+	std::vector<InputState> loaded;
+	loaded.reserve(h.tickCount);
+	for (const Run& r : runs) {
+		InputState s;
+		s.buttons = r.buttons;
+		s.aim = { r.aimX, r.aimY };
+		loaded.insert(loaded.end(), r.count, s);
+	}
+
+	ticks = std::move(loaded);
+	tickRate = h.tickRate;
+	seed = h.seed;
+	checksum = h.checksum;
+	mode = Live;
+	replayTick = 0;
+	return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <SFML/Graphics.hpp>
+
+// What the simulation reads from the player in one tick.
+struct InputState {
+	enum Button : uint8_t {
+		Left = 1,
+		Right = 2,
+		Jump = 4,
+		Fire = 8
+	};
+
+	uint8_t buttons = 0;
+	sf::Vector2f aim;	// pointer in world coordinates
+
+	bool isDown(Button b) const { return (buttons & b) != 0; }
+	bool operator==(const InputState& o) const { return buttons == o.buttons && aim == o.aim; }
+	bool operator!=(const InputState& o) const { return !(*this == o); }
+};
+
+// Source of the per-tick InputState. Live polls the keyboard and mouse,
+// Recording polls and keeps every tick, Replaying feeds a recording back
+// and ignores the devices until it runs out.
+// A recording holds the tick rate and random seed it was made with and the
+// state checksum at its last tick, see Game::restart. It is saved run-length
+// encoded: Header | Run[runCount], a run being one state held for count ticks.
+class Input
+{
+public:
+	static constexpr uint32_t MAGIC = 0x524A4E45; // "ENJR"
+	static constexpr uint32_t VERSION = 1;
+
+	enum Mode {
+		Live,
+		Recording,
+		Replaying
+	};
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		uint32_t tickRate;
+		uint32_t seed;
+		uint32_t tickCount;
+		uint32_t runCount;
+		uint64_t checksum;
+	};
+
+	struct Run {
+		uint16_t count;
+		uint8_t buttons;
+		uint8_t pad;
+		float aimX;
+		float aimY;
+	};
+
+	Mode mode = Live;
+	InputState current;
+	std::vector<InputState> ticks;
+	int replayTick = 0;
+	uint32_t tickRate = 120;
+	uint32_t seed = 0;
+	uint64_t checksum = 0;
+
+	void beginTick(const sf::RenderWindow& win);
+	void startRecording(uint32_t pTickRate, uint32_t pSeed);
+	void stopRecording(uint64_t pChecksum);
+	void startReplay();
+	void stopReplay();
+	bool isReplayOver() const { return replayTick >= (int)ticks.size(); }
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+	static InputState poll(const sf::RenderWindow& win);
+};
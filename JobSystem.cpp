@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include "JobSystem.h"
+
+JobSystem::JobSystem() {
+	start(getDefaultWorkerCount());
+}
+
+JobSystem::~JobSystem() {
+	stop();
+}
+
+// one thread per core, the main thread being one of them
+int JobSystem::getDefaultWorkerCount() {
+	int cores = (int)std::thread::hardware_concurrency();
+	return std::max(0, cores - 1);
+}
+
+// queue 0 is the caller's, queue i + 1 belongs to worker i
+void JobSystem::start(int workerCount) {
+	stop();
+	isStopping = false;
+	queues.clear();
+	for (int i = 0; i <= workerCount; i++) queues.push_back(std::make_unique<Queue>());
+	for (int i = 0; i < workerCount; i++) workers.emplace_back(&JobSystem::run, this, i + 1);
+}
+
+void JobSystem::stop() {
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		isStopping = true;
+	}
+	wakeUp.notify_all();
+	for (std::thread& t : workers) t.join();
+	workers.clear();
+}
+
+void JobSystem::parallelFor(int count, int grain, const std::function<void(int, int)>& fn) {
+	if (count <= 0) return;
+	grain = std::max(1, grain);
+	if (workers.empty() || count <= grain) {
+		fn(0, count);
+		return;
+	}
+
+	int jobCount = (count + grain - 1) / grain;
+	remaining.store(jobCount);
+	for (int j = 0; j < jobCount; j++) {
+		Queue& q = *queues[j % queues.size()];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		q.jobs.push_back({ &fn, j * grain, std::min(count, (j + 1) * grain) });
+	}
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex);
+		generation++;
+	}
+	wakeUp.notify_all();
+
+	while (remaining.load() > 0)
+		if (!runOne(0)) std::this_thread::yield();
+}
+
+void JobSystem::run(int self) {
+	uint32_t seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			wakeUp.wait(lock, [&] { return isStopping || generation != seen; });
+			if (isStopping) return;
+			seen = generation;
+		}
+		while (runOne(self)) {}
+	}
+}
+
+// own deque first, then the others starting from the next thread
+bool JobSystem::runOne(int self) {
+	Job job;
+	int n = (int)queues.size();
+	bool isFound = pop(self, true, job);
+	for (int i = 1; i < n && !isFound; i++)
+		isFound = pop((self + i) % n, false, job);
+	if (!isFound) return false;
+
+	(*job.fn)(job.begin, job.end);
+	remaining.fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::pop(int q, bool isOwner, Job& out) {
+	Queue& queue = *queues[q];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty()) return false;
+	if (isOwner) {
+		out = queue.jobs.back();
+		queue.jobs.pop_back();
+	}
+	else {
+		out = queue.jobs.front();
+		queue.jobs.pop_front();
+	}
+	return true;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+// Fixed pool of worker threads with one job deque per thread (the caller
+// included). parallelFor cuts [0, count) into ranges dealt round-robin over
+// the deques; each thread pops its own deque from the back and steals from
+// the front of the others once it runs dry. The caller works too and
+// returns when every range is done.
+// Only the main thread calls parallelFor, one loop at a time. Ranges must
+// only write data owned by their indices, so the result never depends on
+// the thread count or on who ran which range.
+class JobSystem
+{
+public:
+	struct Job {
+		const std::function<void(int, int)>* fn;
+		int begin;
+		int end;
+	};
+
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	~JobSystem();
+
+	void start(int workerCount);
+	void stop();
+	int getWorkerCount() const { return (int)workers.size(); }
+	void parallelFor(int count, int grain, const std::function<void(int, int)>& fn);
+
+	static int getDefaultWorkerCount();
+
+private:
+	std::vector<std::thread> workers;
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::mutex wakeMutex;
+	std::condition_variable wakeUp;
+	uint32_t generation = 0;
+	bool isStopping = false;
+	std::atomic<int> remaining{ 0 };
+
+	void run(int self);
+	bool runOne(int self);
+	bool pop(int q, bool isOwner, Job& out);
+};
@@ -0,0 +1,176 @@
+#include <map>
+#include <cmath>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include "LevelFile.h"
+#include "C.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+LevelFile::~LevelFile() {
+	close();
+}
+
+bool LevelFile::open(const std::string& path) {
+	close();
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	fileHandle = file;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) { close(); return false; }
+	size = (size_t)fileSize.QuadPart;
+	HANDLE map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (map == nullptr) { close(); return false; }
+	mapHandle = map;
+	data = (const uint8_t*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+#else
+	fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) { close(); return false; }
+	size = (size_t)st.st_size;
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	data = (mapped == MAP_FAILED) ? nullptr : (const uint8_t*)mapped;
+#endif
+	if (data == nullptr || !validate()) {
+		std::cout << "LEVEL LOAD ERROR, path : " << path << std::endl;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void LevelFile::close() {
+#ifdef _WIN32
+	if (data) UnmapViewOfFile(data);
+	if (mapHandle) CloseHandle((HANDLE)mapHandle);
+	if (fileHandle) CloseHandle((HANDLE)fileHandle);
+#else
+	if (data) munmap((void*)data, size);
+	if (fd >= 0) ::close(fd);
+#endif
+	data = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mapHandle = nullptr;
+	fd = -1;
+	header = nullptr;
+	chunkTable = nullptr;
+	spawns = nullptr;
+}
+
+bool LevelFile::validate() {
+	if (size < sizeof(Header)) return false;
+	const Header* h = (const Header*)data;
+	if (h->magic != MAGIC || h->version != VERSION) return false;
+	if (h->chunkSize != TileGrid::CHUNK_SIZE || h->layerCount < 1) return false;
+	if (h->chunkCount < 0 || h->enemyCount < 0) return false;
+
+	size_t blockSize = (size_t)h->layerCount * TileGrid::CHUNK_CELLS;
+	size_t tableEnd = sizeof(Header) + (size_t)h->chunkCount * sizeof(ChunkEntry);
+	size_t spawnStart = tableEnd + (size_t)h->chunkCount * blockSize;
+	if (spawnStart + (size_t)h->enemyCount * sizeof(EnemySpawn) > size) return false;
+
+	const ChunkEntry* table = (const ChunkEntry*)(data + sizeof(Header));
+	for (int i = 0; i < h->chunkCount; i++) {
+		const ChunkEntry& e = table[i];
+		if (e.tileOffset < tableEnd || e.tileOffset + blockSize > spawnStart) return false;
+		if ((size_t)e.enemyFirst + e.enemyCount > (size_t)h->enemyCount) return false;
+	}
+
+	header = h;
+	chunkTable = table;
+	spawns = (const EnemySpawn*)(data + spawnStart);
+	return true;
+}
+
+const uint8_t* LevelFile::getTiles(const ChunkEntry& entry, int layer) const {
+	return data + entry.tileOffset + (size_t)layer * TileGrid::CHUNK_CELLS;
+}
+
+bool LevelFile::write(const std::string& path, const TileGrid& grid, const std::vector<sf::Vector2f>& enemySpawns, sf::Vector2f playerStart) {
+	struct Pending {
+		const TileGrid::Chunk* chunk = nullptr;
+		std::vector<EnemySpawn> enemies;
+	};
+
+	// ordered by column first, so a level reads left to right
+	std::map<std::pair<int, int>, Pending> pending;
+	Header h{};
+	h.magic = MAGIC;
+	h.version = VERSION;
+	h.chunkSize = TileGrid::CHUNK_SIZE;
+	h.layerCount = 1;
+	h.playerStartX = playerStart.x;
+	h.playerStartY = playerStart.y;
+	h.minCellX = INT32_MAX;
+	h.minCellY = INT32_MAX;
+	h.maxCellX = INT32_MIN;
+	h.maxCellY = INT32_MIN;
+
+	for (int cy = grid.chunkY0; cy < grid.chunkY0 + grid.chunkRows; cy++)
+		for (int cx = grid.chunkX0; cx < grid.chunkX0 + grid.chunkCols; cx++) {
+			const TileGrid::Chunk* c = grid.getChunk(cx, cy);
+			if (c == nullptr || c->count == 0) continue;
+			pending[{ cx, cy }].chunk = c;
+			for (int i = 0; i < TileGrid::CHUNK_CELLS; i++) {
+				if (c->ids[i] == TileGrid::EMPTY) continue;
+				int x = cx * TileGrid::CHUNK_SIZE + (i & TileGrid::CHUNK_MASK);
+				int y = cy * TileGrid::CHUNK_SIZE + (i >> TileGrid::CHUNK_SHIFT);
+				h.minCellX = std::min(h.minCellX, x);
+				h.minCellY = std::min(h.minCellY, y);
+				h.maxCellX = std::max(h.maxCellX, x);
+				h.maxCellY = std::max(h.maxCellY, y);
+			}
+		}
+	if (pending.empty()) h.minCellX = h.minCellY = h.maxCellX = h.maxCellY = 0;
+
+	for (const sf::Vector2f& p : enemySpawns) {
+		int cx = TileGrid::toChunk((int)std::floor(p.x / C::GRID_SIZE));
+		int cy = TileGrid::toChunk((int)std::floor(p.y / C::GRID_SIZE));
+		pending[{ cx, cy }].enemies.push_back({ p.x, p.y });
+	}
+
+	h.chunkCount = (int32_t)pending.size();
+	h.enemyCount = (int32_t)enemySpawns.size();
+
+	std::vector<ChunkEntry> table;
+	table.reserve(pending.size());
+	uint32_t tileOffset = (uint32_t)(sizeof(Header) + pending.size() * sizeof(ChunkEntry));
+	uint32_t enemyFirst = 0;
+	for (const auto& [key, p] : pending) {
+		table.push_back({ key.first, key.second, tileOffset, enemyFirst, (uint32_t)p.enemies.size() });
+		tileOffset += TileGrid::CHUNK_CELLS * h.layerCount;
+		enemyFirst += (uint32_t)p.enemies.size();
+	}
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	if (!out) {
+		std::cout << "LEVEL SAVE ERROR, path : " << path << std::endl;
+		return false;
+	}
+
+	out.write((const char*)&h, sizeof(Header));
+	out.write((const char*)table.data(), table.size() * sizeof(ChunkEntry));
+	const std::array<uint8_t, TileGrid::CHUNK_CELLS> emptyBlock{};
+	for (const auto& [key, p] : pending)
+		out.write((const char*)(p.chunk ? p.chunk->ids.data() : emptyBlock.data()), TileGrid::CHUNK_CELLS);
+	for (const auto& [key, p] : pending)
+		out.write((const char*)p.enemies.data(), p.enemies.size() * sizeof(EnemySpawn));
+	return (bool)out;
+}
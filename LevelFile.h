@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+
+#include "TileGrid.h"
+
+// Versioned binary level, read through a read-only memory mapping.
+// Layout: Header | ChunkEntry[chunkCount] | tile blocks | EnemySpawn[enemyCount]
+// Each chunk owns layerCount blocks of CHUNK_CELLS tile IDs (layer 0 = walls)
+// and a contiguous range of the spawn table.
+class LevelFile
+{
+public:
+	static constexpr uint32_t MAGIC = 0x4C4A4E45; // "ENJL"
+	static constexpr uint32_t VERSION = 1;
+
+	struct Header {
+		uint32_t magic;
+		uint32_t version;
+		int32_t chunkSize;
+		int32_t layerCount;
+		int32_t chunkCount;
+		int32_t enemyCount;
+		float playerStartX;
+		float playerStartY;
+		int32_t minCellX;
+		int32_t minCellY;
+		int32_t maxCellX;
+		int32_t maxCellY;
+	};
+
+	struct ChunkEntry {
+		int32_t cx;
+		int32_t cy;
+		uint32_t tileOffset;
+		uint32_t enemyFirst;
+		uint32_t enemyCount;
+	};
+
+	struct EnemySpawn {
+		float x;
+		float y;
+	};
+
+	const Header* header = nullptr;
+	const ChunkEntry* chunkTable = nullptr;
+	const EnemySpawn* spawns = nullptr;
+
+	LevelFile() = default;
+	LevelFile(const LevelFile&) = delete;
+	LevelFile& operator=(const LevelFile&) = delete;
+	~LevelFile();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return header != nullptr; }
+	const uint8_t* getTiles(const ChunkEntry& entry, int layer = 0) const;
+
+	static bool write(const std::string& path, const TileGrid& grid, const std::vector<sf::Vector2f>& enemySpawns, sf::Vector2f playerStart);
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	void* fileHandle = nullptr;
+	void* mapHandle = nullptr;
+	int fd = -1;
+
+	bool validate();
+};
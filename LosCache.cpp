@@ -0,0 +1,76 @@
+#include <cmath>
+#include <algorithm>
+
+#include "LosCache.h"
+#include "C.hpp"
+
+uint64_t LosCache::getKey(sf::Vector2i from, sf::Vector2i to) {
+	return ((uint64_t)(uint16_t)from.x << 48) | ((uint64_t)(uint16_t)from.y << 32)
+		| ((uint64_t)(uint16_t)to.x << 16) | (uint64_t)(uint16_t)to.y;
+}
+
+sf::Vector2i LosCache::getFrom(uint64_t key) {
+	return { (int16_t)(key >> 48), (int16_t)(key >> 32) };
+}
+
+sf::Vector2i LosCache::getTo(uint64_t key) {
+	return { (int16_t)(key >> 16), (int16_t)key };
+}
+
+void LosCache::beginTick() {
+	tickHits = 0;
+	tickMisses = 0;
+}
+
+bool LosCache::find(sf::Vector2i from, sf::Vector2i to, bool& isVisible) {
+	auto it = entries.find(getKey(from, to));
+	if (it == entries.end()) {
+		misses++;
+		tickMisses++;
+		return false;
+	}
+	isVisible = it->second;
+	hits++;
+	tickHits++;
+	return true;
+}
+
+// past maxEntries the whole cache goes, the player's current cell refills
+// it within a few ticks
+void LosCache::store(sf::Vector2i from, sf::Vector2i to, bool isVisible) {
+	if (entries.size() >= maxEntries) entries.clear();
+	entries[getKey(from, to)] = isVisible;
+}
+
+// Every line from a point of one cell to a point of the other stays within
+// one cell of the line between the two cell centers, so entries whose
+// center line crosses the edited rect grown by one cell are dropped.
+void LosCache::invalidate(const sf::IntRect& cells) {
+	// EPS keeps the lines grazing a corner, lost to rounding the direction
+	const float m = 1.0f + C::EPS;
+	sf::FloatRect grown = { cells.left - m, cells.top - m, cells.width + m * 2.0f, cells.height + m * 2.0f };
+
+	for (auto it = entries.begin(); it != entries.end();) {
+		sf::Vector2i from = getFrom(it->first);
+		sf::Vector2i to = getTo(it->first);
+		sf::Vector2f a = { from.x + 0.5f, from.y + 0.5f };
+		sf::Vector2f d = { (float)(to.x - from.x), (float)(to.y - from.y) };
+		float length = std::sqrt(d.x * d.x + d.y * d.y);
+		float t;
+
+		if (rayIntersectsRect(a, normalize(d), grown, length, t)) {
+			it = entries.erase(it);
+			invalidated++;
+		}
+		else ++it;
+	}
+}
+
+void LosCache::clear() {
+	entries.clear();
+}
+
+float LosCache::getHitRate() const {
+	uint64_t total = hits + misses;
+	return (total > 0) ? (float)hits / (float)total : 0.0f;
+}
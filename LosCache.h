@@ -0,0 +1,35 @@
+#pragma once
+
+#include <unordered_map>
+#include <cstdint>
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+// Line of sight answers keyed by (enemy cell, player cell). An answer is
+// reused for as long as both ends stay in their cells, so an enemy only
+// raycasts again when it or the player crosses a cell border, or when an
+// edit lands near the line (invalidate). Cell coordinates are packed on 16
+// bits each, far beyond any level size.
+class LosCache
+{
+public:
+	std::unordered_map<uint64_t, bool> entries;
+	size_t maxEntries = 16384;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	uint64_t invalidated = 0;
+	int tickHits = 0;
+	int tickMisses = 0;
+
+	bool find(sf::Vector2i from, sf::Vector2i to, bool& isVisible);
+	void store(sf::Vector2i from, sf::Vector2i to, bool isVisible);
+	void invalidate(const sf::IntRect& cells);
+	void clear();
+	void beginTick();
+	float getHitRate() const;
+
+	static uint64_t getKey(sf::Vector2i from, sf::Vector2i to);
+	static sf::Vector2i getFrom(uint64_t key);
+	static sf::Vector2i getTo(uint64_t key);
+};
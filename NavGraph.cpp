@@ -0,0 +1,268 @@
+#include <cmath>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+#include "NavGraph.h"
+
+NavGraph::NavGraph(float pCellSize, float pJumpSpeed, float pGravity, float pRunSpeed)
+	: cellSize(pCellSize), jumpSpeed(pJumpSpeed), gravity(pGravity), runSpeed(pRunSpeed) {
+}
+
+sf::Vector2i NavGraph::getStandingCell(const sf::FloatRect& box, float cellSize) {
+	return { (int)std::floor((box.left + box.width * 0.5f) / cellSize), (int)std::floor((box.top + box.height - 1.0f) / cellSize) };
+}
+
+// reach[k + maxDrop]: widest gap, in cells from take-off to landing, for a
+// jump that ends k rows higher. Landing is taken on the way down, with one
+// cell kept as margin for the hitbox.
+void NavGraph::computeReach() {
+	float maxHeight = jumpSpeed * jumpSpeed / (2.0f * gravity);
+	jumpRows = (int)(maxHeight / cellSize);
+	reach.assign(maxDrop + jumpRows + 1, 0);
+	for (int k = -maxDrop; k <= jumpRows; k++) {
+		float disc = jumpSpeed * jumpSpeed - 2.0f * gravity * (k * cellSize);
+		float airTime = (jumpSpeed + std::sqrt(std::max(0.0f, disc))) / gravity;
+		reach[k + maxDrop] = std::max(1, (int)(runSpeed * airTime / cellSize) - 1);
+	}
+}
+
+void NavGraph::build(const TileGrid& grid) {
+	nodes.clear();
+	freeNodes.clear();
+	rows.clear();
+	computeReach();
+	version++;
+	if (grid.chunkCols == 0) {
+		countStats();
+		return;
+	}
+
+	int x0 = grid.chunkX0 * TileGrid::CHUNK_SIZE;
+	int y0 = grid.chunkY0 * TileGrid::CHUNK_SIZE;
+	int x1 = (grid.chunkX0 + grid.chunkCols) * TileGrid::CHUNK_SIZE - 1;
+	int y1 = (grid.chunkY0 + grid.chunkRows) * TileGrid::CHUNK_SIZE - 1;
+	for (int y = y0 - 1; y <= y1; y++)
+		for (int cx = TileGrid::toChunk(x0); cx <= TileGrid::toChunk(x1); cx++)
+			scanRow(grid, y, cx * TileGrid::CHUNK_SIZE, cx * TileGrid::CHUNK_SIZE + TileGrid::CHUNK_MASK);
+	for (int id = 0; id < (int)nodes.size(); id++)
+		if (nodes[id].isAlive) linkNode(grid, id);
+	countStats();
+}
+
+// Rescans the spans the edited cells can change (their rows and the row
+// above, over their chunk columns), then relinks every span whose links
+// can reach those rows or depend on the edited columns.
+void NavGraph::rebuild(const TileGrid& grid, const sf::IntRect& cells) {
+	if (reach.empty()) computeReach();
+	int top = cells.top - 1;
+	int bottom = cells.top + cells.height - 1;
+	int cx0 = TileGrid::toChunk(cells.left);
+	int cx1 = TileGrid::toChunk(cells.left + cells.width - 1);
+	int left = cx0 * TileGrid::CHUNK_SIZE;
+	int right = cx1 * TileGrid::CHUNK_SIZE + TileGrid::CHUNK_MASK;
+
+	for (int y = top; y <= bottom; y++) {
+		auto it = rows.find(y);
+		if (it != rows.end()) {
+			std::vector<int> ids = it->second;
+			for (int id : ids)
+				if (nodes[id].x0 >= left && nodes[id].x0 <= right) removeNode(id);
+		}
+		for (int cx = cx0; cx <= cx1; cx++)
+			scanRow(grid, y, cx * TileGrid::CHUNK_SIZE, cx * TileGrid::CHUNK_SIZE + TileGrid::CHUNK_MASK);
+	}
+
+	int maxReach = *std::max_element(reach.begin(), reach.end()) + 1;
+	int relinkLeft = left - maxReach - TileGrid::CHUNK_SIZE;
+	int relinkRight = right + maxReach;
+	for (int y = top - maxDrop - 1; y <= bottom + jumpRows + 1; y++) {
+		auto it = rows.find(y);
+		if (it == rows.end()) continue;
+		for (int id : it->second)
+			if (nodes[id].x0 >= relinkLeft && nodes[id].x0 <= relinkRight) {
+				nodes[id].links.clear();
+				linkNode(grid, id);
+			}
+	}
+	version++;
+	countStats();
+}
+
+int NavGraph::addNode(int y, int x0, int x1) {
+	int id;
+	if (!freeNodes.empty()) {
+		id = freeNodes.back();
+		freeNodes.pop_back();
+	}
+	else {
+		id = (int)nodes.size();
+		nodes.emplace_back();
+	}
+	Node& n = nodes[id];
+	n.y = y;
+	n.x0 = x0;
+	n.x1 = x1;
+	n.isAlive = true;
+	n.links.clear();
+
+	std::vector<int>& row = rows[y];
+	auto at = std::lower_bound(row.begin(), row.end(), x0, [&](int other, int x) { return nodes[other].x0 < x; });
+	row.insert(at, id);
+	return id;
+}
+
+void NavGraph::removeNode(int id) {
+	Node& n = nodes[id];
+	std::vector<int>& row = rows[n.y];
+	row.erase(std::find(row.begin(), row.end(), id));
+	n.isAlive = false;
+	n.links.clear();
+	freeNodes.push_back(id);
+}
+
+void NavGraph::scanRow(const TileGrid& grid, int y, int x0, int x1) {
+	int start = INT_MIN;
+	for (int x = x0; x <= x1 + 1; x++) {
+		bool isWalkable = x <= x1 && grid.get(x, y) == TileGrid::EMPTY && grid.get(x, y + 1) != TileGrid::EMPTY;
+		if (isWalkable && start == INT_MIN) start = x;
+		else if (!isWalkable && start != INT_MIN) {
+			addNode(y, start, x - 1);
+			start = INT_MIN;
+		}
+	}
+}
+
+int NavGraph::findNode(int x, int y) const {
+	auto it = rows.find(y);
+	if (it == rows.end()) return -1;
+	const std::vector<int>& row = it->second;
+	auto at = std::upper_bound(row.begin(), row.end(), x, [&](int v, int id) { return v < nodes[id].x0; });
+	if (at == row.begin()) return -1;
+	int id = *(at - 1);
+	return (x <= nodes[id].x1) ? id : -1;
+}
+
+void NavGraph::tryLink(int from, int to, LinkType type, int dir, int fromX, int toX) {
+	if (to < 0 || to == from) return;
+	float cost = (float)std::abs(toX - fromX) + std::abs(nodes[to].y - nodes[from].y) * 0.5f;
+	if (type == Jump) cost += 2.0f;
+	nodes[from].links.push_back({ to, type, dir, fromX, toX, cost });
+}
+
+void NavGraph::linkNode(const TileGrid& grid, int id) {
+	const int y = nodes[id].y;
+	for (int dir = -1; dir <= 1; dir += 2) {
+		const int edge = (dir > 0) ? nodes[id].x1 : nodes[id].x0;
+		const int next = edge + dir;
+
+		int walkTo = findNode(next, y);
+		if (walkTo >= 0) tryLink(id, walkTo, Walk, dir, edge, next);
+		else if (grid.get(next, y) == TileGrid::EMPTY) {
+			uint8_t fall = grid.getFloorDist(next, y);
+			if (fall != TileGrid::NO_FLOOR) tryLink(id, findNode(next, y + fall), Drop, dir, edge, next);
+		}
+
+		if (grid.get(edge, y - 1) != TileGrid::EMPTY) continue;
+		for (int k = -maxDrop; k <= jumpRows; k++) {
+			auto it = rows.find(y - k);
+			if (it == rows.end()) continue;
+			int gap = reach[k + maxDrop];
+			int lo = (dir > 0) ? edge + 1 : edge - gap;
+			int hi = (dir > 0) ? edge + gap : edge - 1;
+			const std::vector<int>& row = it->second;
+			auto first = std::lower_bound(row.begin(), row.end(), lo - TileGrid::CHUNK_SIZE,
+				[&](int other, int x) { return nodes[other].x0 < x; });
+			for (auto at = first; at != row.end() && nodes[*at].x0 <= hi; ++at) {
+				const Node& b = nodes[*at];
+				int landX = (dir > 0) ? b.x0 : b.x1;
+				if (landX < lo || landX > hi) continue;
+				if (k == 0 && landX == next) continue;
+				tryLink(id, *at, Jump, dir, edge, landX);
+			}
+		}
+	}
+}
+
+void NavGraph::countStats() {
+	aliveNodes = 0;
+	linkCount = 0;
+	for (const Node& n : nodes)
+		if (n.isAlive) {
+			aliveNodes++;
+			linkCount += (int)n.links.size();
+		}
+}
+
+// Dijkstra from the target over reversed links: flowCost is the cost from a
+// span to the target, flowLink the link to take. Reruns only when the
+// target span or the graph changed.
+void NavGraph::updateFlow(int target) {
+	if (target == flowTarget && flowVersion == version) return;
+	flowTarget = target;
+	flowVersion = version;
+	int n = (int)nodes.size();
+	flowCost.assign(n, std::numeric_limits<float>::infinity());
+	flowLink.assign(n, -1);
+	if (target < 0 || target >= n || !nodes[target].isAlive) return;
+
+	reverse.resize(n);
+	for (auto& r : reverse) r.clear();
+	for (int a = 0; a < n; a++)
+		for (int l = 0; l < (int)nodes[a].links.size(); l++)
+			reverse[nodes[a].links[l].to].push_back({ a, l });
+
+	typedef std::pair<float, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	flowCost[target] = 0.0f;
+	open.push({ 0.0f, target });
+	while (!open.empty()) {
+		auto [cost, b] = open.top();
+		open.pop();
+		if (cost > flowCost[b]) continue;
+		for (auto [a, l] : reverse[b]) {
+			float c = cost + nodes[a].links[l].cost;
+			if (c < flowCost[a]) {
+				flowCost[a] = c;
+				flowLink[a] = l;
+				open.push({ c, a });
+			}
+		}
+	}
+}
+
+const NavGraph::Link* NavGraph::getNextLink(int from) const {
+	if (from < 0 || from == flowTarget || from >= (int)flowLink.size() || flowLink[from] < 0) return nullptr;
+	return &nodes[from].links[flowLink[from]];
+}
+
+// one-off query between two spans, the chase itself goes through updateFlow
+bool NavGraph::findPath(int from, int to, std::vector<int>& outNodes) {
+	outNodes.clear();
+	int n = (int)nodes.size();
+	if (from < 0 || to < 0 || from >= n || to >= n) return false;
+
+	std::vector<float> cost(n, std::numeric_limits<float>::infinity());
+	std::vector<int> parent(n, -1);
+	typedef std::pair<float, int> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	cost[from] = 0.0f;
+	open.push({ 0.0f, from });
+	while (!open.empty()) {
+		auto [c, a] = open.top();
+		open.pop();
+		if (a == to) break;
+		if (c > cost[a]) continue;
+		for (const Link& l : nodes[a].links)
+			if (c + l.cost < cost[l.to]) {
+				cost[l.to] = c + l.cost;
+				parent[l.to] = a;
+				open.push({ cost[l.to], l.to });
+			}
+	}
+	if (cost[to] == std::numeric_limits<float>::infinity()) return false;
+	for (int v = to; v != -1; v = parent[v]) outNodes.push_back(v);
+	std::reverse(outNodes.begin(), outNodes.end());
+	return true;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <vector>
+#include <climits>
+#include <cstdint>
+#include <unordered_map>
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include "TileGrid.h"
+
+// Platform navigation graph over the tile grid. A node is a walkable span:
+// a run of empty cells on one row, each standing on a solid cell, cut at
+// chunk columns so an edit only rescans the spans of its own chunk.
+// Links leave a span from one of its ends:
+//  - Walk to the span continuing it in the next chunk,
+//  - Drop off the end, straight down to the span below (floorDist),
+//  - Jump to a span whose near end is within the reach of a jump, taken
+//    from the jump impulse, gravity and run speed of an enemy.
+// updateFlow runs one Dijkstra from the target span over reversed links, so
+// every chasing enemy reads its next link with getNextLink in O(1).
+class NavGraph
+{
+public:
+	enum LinkType : uint8_t {
+		Walk,
+		Drop,
+		Jump
+	};
+
+	struct Link {
+		int to;
+		LinkType type;
+		int dir;		// -1 leaves from x0, +1 from x1
+		int fromX;		// cell to leave from (jump take-off)
+		int toX;		// cell landed on
+		float cost;
+	};
+
+	struct Node {
+		int y = 0;
+		int x0 = 0;
+		int x1 = -1;
+		bool isAlive = false;
+		std::vector<Link> links;
+	};
+
+	// enemy movement, given by WallMap from Entity and Enemy
+	float cellSize;
+	float jumpSpeed;
+	float gravity;
+	float runSpeed;
+	int maxDrop = TileGrid::MAX_FLOOR_DIST;
+
+	std::vector<Node> nodes;
+	std::vector<int> freeNodes;
+	std::unordered_map<int, std::vector<int>> rows;
+	int jumpRows = 0;
+	std::vector<int> reach;		// max gap in cells, by rows climbed + maxDrop
+
+	int flowTarget = -1;
+	uint32_t version = 0;
+	uint32_t flowVersion = UINT32_MAX;
+	std::vector<float> flowCost;
+	std::vector<int> flowLink;
+	int aliveNodes = 0;
+	int linkCount = 0;
+	double lastBuildTime = 0.0;
+
+	NavGraph(float pCellSize, float pJumpSpeed, float pGravity, float pRunSpeed);
+	void build(const TileGrid& grid);
+	void rebuild(const TileGrid& grid, const sf::IntRect& cells);
+	int findNode(int x, int y) const;
+	void updateFlow(int target);
+	const Link* getNextLink(int from) const;
+	bool findPath(int from, int to, std::vector<int>& outNodes);
+
+	static sf::Vector2i getStandingCell(const sf::FloatRect& box, float cellSize);
+
+private:
+	std::vector<std::vector<std::pair<int, int>>> reverse;
+
+	void computeReach();
+	int addNode(int y, int x0, int x1);
+	void removeNode(int id);
+	void scanRow(const TileGrid& grid, int y, int x0, int x1);
+	void linkNode(const TileGrid& grid, int id);
+	void tryLink(int from, int to, LinkType type, int dir, int fromX, int toX);
+	void countStats();
+};
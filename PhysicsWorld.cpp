@@ -0,0 +1,373 @@
+#include <cstring>
+#include <algorithm>
+
+#include "PhysicsWorld.h"
+#include "Entity.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PHYSICS_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHYSICS_SSE2
+#endif
+
+void PhysicsWorld::resize(int count) {
+	for (std::vector<float>* v : { &posX, &posY, &dx, &dy, &addedX, &addedY, &speedX, &speedY, &accY, &dyMax,
+		&originX, &originY, &padLeft, &padTop, &boxW, &boxH, &vBoxLeft, &vBoxTop, &hBoxLeft, &hBoxTop })
+		v->resize(count, 0.0f);
+	flags.resize(count, 0);
+}
+
+void PhysicsWorld::setShape(int i, const Entity& e) {
+	sf::Vector2f orgn = e.animSprite.sprite.getOrigin();
+	originX[i] = orgn.x * e.scale.x;
+	originY[i] = orgn.y * e.scale.y;
+	padLeft[i] = e.leftPaddingBox;
+	padTop[i] = e.topPaddingBox;
+	boxW[i] = e.vBox.width;
+	boxH[i] = e.vBox.height;
+	accY[i] = e.accY;
+	dyMax[i] = e.dyMax;
+}
+
+void PhysicsWorld::gather(int i, const Entity& e) {
+	posX[i] = e.pos.x;
+	posY[i] = e.pos.y;
+	dx[i] = e.dx;
+	dy[i] = e.dy;
+	addedX[i] = e.addedX;
+	addedY[i] = e.addedY;
+	flags[i] = Active | (e.isGrounded ? Grounded : 0) | (e.justJump ? JustJumped : 0);
+}
+
+void PhysicsWorld::scatter(int i, Entity& e) const {
+	e.pos = { posX[i], posY[i] };
+	e.dx = dx[i];
+	e.dy = dy[i];
+	e.addedX = addedX[i];
+	e.addedY = addedY[i];
+	e.speedX = speedX[i];
+	e.speedY = speedY[i];
+	e.isGrounded = (flags[i] & Grounded) != 0;
+	e.justJump = (flags[i] & JustJumped) != 0;
+	e.vBox.left = vBoxLeft[i];
+	e.vBox.top = vBoxTop[i];
+	e.hBox.left = hBoxLeft[i];
+	e.hBox.top = hBoxTop[i];
+	e.animSprite.sprite.setPosition(e.pos);
+}
+
+// same stage order as Entity::updatePhysics
+void PhysicsWorld::step(double dt, const TileGrid& grid) {
+	applyGravity(dt);
+	applyVelocity();
+	resolveCollisions(dt, grid);
+	integrate(dt);
+	dampAddedMovement();
+}
+
+// each kernel returns how many bodies it did, the scalar loop does the tail
+void PhysicsWorld::applyGravity(double dt) {
+	const int n = size();
+	for (int i = useSimd ? applyGravitySimd(dt) : 0; i < n; i++) {
+		if (flags[i] & Grounded) continue;
+		dy[i] += accY[i] * 2.0f * dt;
+		if (dy[i] >= dyMax[i]) dy[i] = dyMax[i];
+	}
+}
+
+void PhysicsWorld::applyVelocity() {
+	const int n = size();
+	for (int i = useSimd ? applyVelocitySimd() : 0; i < n; i++) {
+		speedX[i] = dx[i] + addedX[i];
+		speedY[i] = dy[i] + addedY[i];
+	}
+}
+
+// Entity::handleCollisions and checkGround
+void PhysicsWorld::resolveCollisions(double dt, const TileGrid& grid) {
+	const float g = (float)C::GRID_SIZE;
+	const int n = size();
+	for (int i = 0; i < n; i++) {
+		if (!(flags[i] & Active)) continue;
+		float left = posX[i] - originX[i] + padLeft[i];
+		float top = posY[i] - originY[i] + padTop[i];
+		float distX = (float)(speedX[i] * dt);
+		float distY = (float)(speedY[i] * dt);
+		Sweep vHit = sweepY(grid, left, top, boxW[i], boxH[i], distY);
+		float moveY = distY * vHit.time;
+		Sweep hHit = sweepX(grid, left, top + moveY, boxW[i], boxH[i], distX);
+
+		bool isGrounded = false;
+		bool isJustJumped = (flags[i] & JustJumped) != 0;
+		double dy0 = speedY[i];
+		if (vHit.normal != 0) {
+			isGrounded = vHit.normal < 0;
+			posY[i] += moveY;
+			dy[i] = 0.0f;
+			speedY[i] = 0.0f;
+		}
+		if (hHit.normal != 0) {
+			posX[i] += distX * hHit.time;
+			dx[i] = 0.0f;
+			speedX[i] = 0.0f;
+		}
+		left = posX[i] - originX[i] + padLeft[i];
+		top = posY[i] - originY[i] + padTop[i];
+
+		vBoxLeft[i] = left;
+		vBoxTop[i] = top + speedY[i] * dt;
+		hBoxLeft[i] = left + speedX[i] * dt;
+		hBoxTop[i] = top;
+
+		if (!(dy0 < 0.0f || isJustJumped)) {
+			int x0 = (int)(hBoxLeft[i] / g);
+			int x1 = (int)((hBoxLeft[i] + boxW[i] - C::EPS) / g);
+			int gY = (int)((hBoxTop[i] + boxH[i] + 1.0f) / g);
+			isGrounded = grid.anyInRow(gY, x0, x1);
+		}
+		flags[i] = Active | (isGrounded ? Grounded : 0);
+	}
+}
+
+void PhysicsWorld::integrate(double dt) {
+	const int n = size();
+	for (int i = useSimd ? integrateSimd(dt) : 0; i < n; i++) {
+		posX[i] += speedX[i] * dt;
+		posY[i] += speedY[i] * dt;
+	}
+}
+
+void PhysicsWorld::dampAddedMovement() {
+	const int n = size();
+	for (int i = useSimd ? dampAddedMovementSimd() : 0; i < n; i++) {
+		addedX[i] *= 0.8f;
+		addedY[i] *= 0.8f;
+		if (addedX[i] < 0.1f && addedX[i] > -0.1f) addedX[i] = 0.0f;
+		if (addedY[i] < 0.1f && addedY[i] > -0.1f) addedY[i] = 0.0f;
+	}
+}
+
+// Walks every column the leading edge crosses, so a move longer than a tile
+// still stops at the first wall. Rows are taken as in the old edge probes.
+PhysicsWorld::Sweep PhysicsWorld::sweepX(const TileGrid& grid, float left, float top, float width, float height, float dist) {
+	const float g = (float)C::GRID_SIZE;
+	Sweep hit;
+	int y0 = (int)((top + C::EPS) / g);
+	int y1 = (int)((top + height - C::EPS) / g);
+	if (dist > 0.0f) {
+		float edge = left + width;
+		int last = (int)((edge + dist) / g);
+		for (int x = (int)(edge / g); x <= last; x++)
+			if (grid.anyInCol(x, y0, y1)) {
+				hit.time = std::max(0.0f, (x * g - edge) / dist);
+				hit.normal = -1;
+				break;
+			}
+	}
+	else if (dist < 0.0f) {
+		int last = (int)((left + dist) / g);
+		for (int x = (int)(left / g); x >= last; x--)
+			if (grid.anyInCol(x, y0, y1)) {
+				hit.time = std::max(0.0f, ((x + 1) * g - left) / dist);
+				hit.normal = 1;
+				break;
+			}
+	}
+	return hit;
+}
+
+PhysicsWorld::Sweep PhysicsWorld::sweepY(const TileGrid& grid, float left, float top, float width, float height, float dist) {
+	const float g = (float)C::GRID_SIZE;
+	Sweep hit;
+	int x0 = (int)(left / g);
+	int x1 = (int)((left + width - C::EPS) / g);
+	if (dist > 0.0f) {
+		float edge = top + height;
+		int last = (int)((edge + dist) / g);
+		for (int y = (int)(edge / g); y <= last; y++)
+			if (grid.anyInRow(y, x0, x1)) {
+				hit.time = std::max(0.0f, (y * g - edge) / dist);
+				hit.normal = -1;
+				break;
+			}
+	}
+	else if (dist < 0.0f) {
+		int last = (int)((top + dist + C::EPS) / g);
+		for (int y = (int)((top + C::EPS) / g); y >= last; y--)
+			if (grid.anyInRow(y, x0, x1)) {
+				hit.time = std::max(0.0f, ((y + 1) * g - top) / dist);
+				hit.normal = 1;
+				break;
+			}
+	}
+	return hit;
+}
+
+const char* PhysicsWorld::getSimdName() {
+#if defined(PHYSICS_AVX)
+	return "AVX";
+#elif defined(PHYSICS_SSE2)
+	return "SSE2";
+#else
+	return "none";
+#endif
+}
+
+#if defined(PHYSICS_AVX)
+
+// float x 8 <-> two double x 4 halves, for the steps done in double
+static inline __m256d lowToDouble(__m256 v) { return _mm256_cvtps_pd(_mm256_castps256_ps128(v)); }
+static inline __m256d highToDouble(__m256 v) { return _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)); }
+static inline __m256 toFloat(__m256d lo, __m256d hi) {
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+}
+
+// all ones in the lanes of bodies without the Grounded flag
+static inline __m256 airborneMask(const uint8_t* flags) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i grounded = _mm_set1_epi32(PhysicsWorld::Grounded);
+	int lo, hi;
+	std::memcpy(&lo, flags, 4);
+	std::memcpy(&hi, flags + 4, 4);
+	__m128i l = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(lo), zero), zero);
+	__m128i h = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(hi), zero), zero);
+	l = _mm_cmpeq_epi32(_mm_and_si128(l, grounded), zero);
+	h = _mm_cmpeq_epi32(_mm_and_si128(h, grounded), zero);
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_castsi128_ps(l)), _mm_castsi128_ps(h), 1);
+}
+
+int PhysicsWorld::applyGravitySimd(double dt) {
+	const int n = size() & ~7;
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256d dtv = _mm256_set1_pd(dt);
+	for (int i = 0; i < n; i += 8) {
+		__m256 v = _mm256_loadu_ps(&dy[i]);
+		__m256 acc = _mm256_mul_ps(_mm256_loadu_ps(&accY[i]), two);
+		__m256d lo = _mm256_add_pd(lowToDouble(v), _mm256_mul_pd(lowToDouble(acc), dtv));
+		__m256d hi = _mm256_add_pd(highToDouble(v), _mm256_mul_pd(highToDouble(acc), dtv));
+		__m256 next = toFloat(lo, hi);
+		__m256 maxV = _mm256_loadu_ps(&dyMax[i]);
+		next = _mm256_blendv_ps(next, maxV, _mm256_cmp_ps(next, maxV, _CMP_GE_OQ));
+		_mm256_storeu_ps(&dy[i], _mm256_blendv_ps(v, next, airborneMask(&flags[i])));
+	}
+	return n;
+}
+
+int PhysicsWorld::applyVelocitySimd() {
+	const int n = size() & ~7;
+	for (int i = 0; i < n; i += 8) {
+		_mm256_storeu_ps(&speedX[i], _mm256_add_ps(_mm256_loadu_ps(&dx[i]), _mm256_loadu_ps(&addedX[i])));
+		_mm256_storeu_ps(&speedY[i], _mm256_add_ps(_mm256_loadu_ps(&dy[i]), _mm256_loadu_ps(&addedY[i])));
+	}
+	return n;
+}
+
+int PhysicsWorld::integrateSimd(double dt) {
+	const int n = size() & ~7;
+	const __m256d dtv = _mm256_set1_pd(dt);
+	for (int i = 0; i < n; i += 8)
+		for (int axis = 0; axis < 2; axis++) {
+			float* p = (axis == 0) ? &posX[i] : &posY[i];
+			__m256 v = _mm256_loadu_ps(p);
+			__m256 speed = _mm256_loadu_ps((axis == 0) ? &speedX[i] : &speedY[i]);
+			__m256d lo = _mm256_add_pd(lowToDouble(v), _mm256_mul_pd(lowToDouble(speed), dtv));
+			__m256d hi = _mm256_add_pd(highToDouble(v), _mm256_mul_pd(highToDouble(speed), dtv));
+			_mm256_storeu_ps(p, toFloat(lo, hi));
+		}
+	return n;
+}
+
+int PhysicsWorld::dampAddedMovementSimd() {
+	const int n = size() & ~7;
+	const __m256 damping = _mm256_set1_ps(0.8f);
+	const __m256 snap = _mm256_set1_ps(0.1f);
+	const __m256 negSnap = _mm256_set1_ps(-0.1f);
+	for (int i = 0; i < n; i += 8)
+		for (float* p : { &addedX[i], &addedY[i] }) {
+			__m256 v = _mm256_mul_ps(_mm256_loadu_ps(p), damping);
+			__m256 isSmall = _mm256_and_ps(_mm256_cmp_ps(v, snap, _CMP_LT_OQ), _mm256_cmp_ps(v, negSnap, _CMP_GT_OQ));
+			_mm256_storeu_ps(p, _mm256_andnot_ps(isSmall, v));
+		}
+	return n;
+}
+
+#elif defined(PHYSICS_SSE2)
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// float x 4 -> two double x 2 halves, for the steps done in double
+static inline __m128 addScaled(__m128 v, __m128 scaled, __m128d dtv) {
+	__m128d lo = _mm_add_pd(_mm_cvtps_pd(v), _mm_mul_pd(_mm_cvtps_pd(scaled), dtv));
+	__m128d hi = _mm_add_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(scaled, scaled)), dtv));
+	return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+}
+
+// all ones in the lanes of bodies without the Grounded flag
+static inline __m128 airborneMask(const uint8_t* flags) {
+	const __m128i zero = _mm_setzero_si128();
+	int bits;
+	std::memcpy(&bits, flags, 4);
+	__m128i f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+	f = _mm_cmpeq_epi32(_mm_and_si128(f, _mm_set1_epi32(PhysicsWorld::Grounded)), zero);
+	return _mm_castsi128_ps(f);
+}
+
+int PhysicsWorld::applyGravitySimd(double dt) {
+	const int n = size() & ~3;
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128d dtv = _mm_set1_pd(dt);
+	for (int i = 0; i < n; i += 4) {
+		__m128 v = _mm_loadu_ps(&dy[i]);
+		__m128 next = addScaled(v, _mm_mul_ps(_mm_loadu_ps(&accY[i]), two), dtv);
+		__m128 maxV = _mm_loadu_ps(&dyMax[i]);
+		next = select(_mm_cmpge_ps(next, maxV), maxV, next);
+		_mm_storeu_ps(&dy[i], select(airborneMask(&flags[i]), next, v));
+	}
+	return n;
+}
+
+int PhysicsWorld::applyVelocitySimd() {
+	const int n = size() & ~3;
+	for (int i = 0; i < n; i += 4) {
+		_mm_storeu_ps(&speedX[i], _mm_add_ps(_mm_loadu_ps(&dx[i]), _mm_loadu_ps(&addedX[i])));
+		_mm_storeu_ps(&speedY[i], _mm_add_ps(_mm_loadu_ps(&dy[i]), _mm_loadu_ps(&addedY[i])));
+	}
+	return n;
+}
+
+int PhysicsWorld::integrateSimd(double dt) {
+	const int n = size() & ~3;
+	const __m128d dtv = _mm_set1_pd(dt);
+	for (int i = 0; i < n; i += 4) {
+		_mm_storeu_ps(&posX[i], addScaled(_mm_loadu_ps(&posX[i]), _mm_loadu_ps(&speedX[i]), dtv));
+		_mm_storeu_ps(&posY[i], addScaled(_mm_loadu_ps(&posY[i]), _mm_loadu_ps(&speedY[i]), dtv));
+	}
+	return n;
+}
+
+int PhysicsWorld::dampAddedMovementSimd() {
+	const int n = size() & ~3;
+	const __m128 damping = _mm_set1_ps(0.8f);
+	const __m128 snap = _mm_set1_ps(0.1f);
+	const __m128 negSnap = _mm_set1_ps(-0.1f);
+	for (int i = 0; i < n; i += 4)
+		for (float* p : { &addedX[i], &addedY[i] }) {
+			__m128 v = _mm_mul_ps(_mm_loadu_ps(p), damping);
+			__m128 isSmall = _mm_and_ps(_mm_cmplt_ps(v, snap), _mm_cmpgt_ps(v, negSnap));
+			_mm_storeu_ps(p, _mm_andnot_ps(isSmall, v));
+		}
+	return n;
+}
+
+#else
+
+int PhysicsWorld::applyGravitySimd(double dt) { return 0; }
+int PhysicsWorld::applyVelocitySimd() { return 0; }
+int PhysicsWorld::integrateSimd(double dt) { return 0; }
+int PhysicsWorld::dampAddedMovementSimd() { return 0; }
+
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "TileGrid.h"
+
+class Entity;
+
+// Structure-of-arrays physics state for a batch of entities, body i
+// mirroring entity i. gather() copies what gameplay code may have written
+// since the last tick (input, AI, recoil), step() runs each stage as one
+// loop over every body and scatter() writes the results back.
+// The stages follow Entity::updatePhysics operation for operation, so a
+// batched entity ends up exactly where the per-object path puts it. Both
+// resolve tile collisions with the sweeps below.
+// Gravity, velocity, integration and damping also have SIMD kernels (AVX
+// when the build targets it, SSE2 otherwise) that keep the same float and
+// double steps per lane and give the same bits as the scalar loops.
+class PhysicsWorld
+{
+public:
+	enum Flag : uint8_t {
+		Active = 1,
+		Grounded = 2,
+		JustJumped = 4
+	};
+
+	// result of sweeping a hitbox along one axis through the tile grid
+	struct Sweep {
+		float time = 1.0f;	// fraction of the move done before contact
+		int normal = 0;		// contact normal on the swept axis, 0 if the move is free
+	};
+
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> dx;
+	std::vector<float> dy;
+	std::vector<float> addedX;
+	std::vector<float> addedY;
+	std::vector<float> speedX;
+	std::vector<float> speedY;
+	std::vector<float> accY;
+	std::vector<float> dyMax;
+	std::vector<uint8_t> flags;
+
+	// hitbox: pos - origin + padding, then width x height
+	std::vector<float> originX;
+	std::vector<float> originY;
+	std::vector<float> padLeft;
+	std::vector<float> padTop;
+	std::vector<float> boxW;
+	std::vector<float> boxH;
+
+	// collision probe boxes, as left by Entity::handleCollisions
+	std::vector<float> vBoxLeft;
+	std::vector<float> vBoxTop;
+	std::vector<float> hBoxLeft;
+	std::vector<float> hBoxTop;
+
+	bool useSimd = true;
+
+	int size() const { return (int)posX.size(); }
+	void resize(int count);
+	void setShape(int i, const Entity& e);
+	void gather(int i, const Entity& e);
+	void scatter(int i, Entity& e) const;
+
+	void step(double dt, const TileGrid& grid);
+	void applyGravity(double dt);
+	void applyVelocity();
+	void resolveCollisions(double dt, const TileGrid& grid);
+	void integrate(double dt);
+	void dampAddedMovement();
+
+	static const char* getSimdName();
+	static Sweep sweepX(const TileGrid& grid, float left, float top, float width, float height, float dist);
+	static Sweep sweepY(const TileGrid& grid, float left, float top, float width, float height, float dist);
+
+private:
+	int applyGravitySimd(double dt);
+	int applyVelocitySimd();
+	int integrateSimd(double dt);
+	int dampAddedMovementSimd();
+};
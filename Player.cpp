@@ -35,28 +35,29 @@ void Player::update(double dt) {
 
 void Player::draw(sf::RenderWindow& win) {
 	Entity::draw(win);
-	if (!isDead) weapon.draw(win);
+	if (!isDead) weapon.draw(win, renderStates);
 }
 
+// input is set by Game::step from the live devices or a replay
 void Player::getInputs(double dt) {
 
-	if ((!sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q) && !sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D)) || isDead)
+	if ((!input.isDown(InputState::Left) && !input.isDown(InputState::Right)) || isDead)
 		stopMoveX(dt);
 
 	if (isDead) return;
 
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Q))
+	if (input.isDown(InputState::Left))
 		moveX(dt, false, dxMax);
 
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::D))
+	if (input.isDown(InputState::Right))
 		moveX(dt, true, dxMax);
 
-	if (sf::Keyboard::isKeyPressed(sf::Keyboard::Key::Space))
+	if (input.isDown(InputState::Jump))
 		onSpacePressed();
 	else
 		wasSpacePressed = false;
 
-	if (sf::Mouse::isButtonPressed(sf::Mouse::Left))
+	if (input.isDown(InputState::Fire))
 		weapon.shoot(dt);
 }
 
@@ -86,4 +87,30 @@ void Player::setForEditorInstance(sf::Vector2f pPos) {
 	weapon.targetPos = pPos + weapon.offset;
 	weapon.pos = weapon.targetPos;
 	weapon.animSprite.sprite.setPosition(weapon.targetPos);
+}
+
+// back to the state of a fresh start, see Game::restart
+void Player::respawn(sf::Vector2f pPos) {
+	isDead = false;
+	isTakingDamage = false;
+	isGrounded = false;
+	justJump = false;
+	animSprite.sprite.setColor(sf::Color(255, 255, 255));
+	life = 3;
+	dx = 0.0f;
+	dy = 0.0f;
+	addedX = 0.0f;
+	addedY = 0.0f;
+	dmgTimer = 0.0;
+	wasSpacePressed = false;
+	input = InputState();
+	weapon.reloadTimer = 0.0f;
+	weapon.canShoot = true;
+	weapon.aimedAngle = 0.0f;
+	// the facing picks dxMax or dxRMax in moveX, which runs before updateSense
+	setSense(1.0f);
+	weapon.setSense(1.0f);
+	weapon.animSprite.sprite.setRotation(0.0f);
+	setForEditorInstance(pPos);
+	savePrevPos();
 }
\ No newline at end of file
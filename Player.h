@@ -7,6 +7,7 @@
 #include <SFML/System/Vector2.hpp>
 #include "Entity.h"
 #include "Pointer.h"
+#include "Input.h"
 #include "PlayerWeapon.h"
 
 class Player : public Entity
@@ -14,6 +15,7 @@ class Player : public Entity
 public:
     Pointer& pointer;
     PlayerWeapon weapon;
+    InputState input;
     bool wasSpacePressed;
     bool isGameInEditor;
 
@@ -25,4 +27,5 @@ public:
     void loadAnimations();
     void updateSense();
     void setForEditorInstance(sf::Vector2f pPos);
+    void respawn(sf::Vector2f pPos);
 };
\ No newline at end of file
@@ -16,7 +16,6 @@ PlayerWeapon::PlayerWeapon(Player& pPlayer, const std::string& pTexPath, sf::Vec
 	targetPos = pos;
 	animSprite.sprite.setPosition(pos);
 	loadAnimations();
-	bulletTex.loadFromFile("res/sprites/bullet.png");
 	laser.setFillColor({ 255, 0, 0, 80 });
 	laser.setOrigin(0.f, thickness * 0.5f);
 }
@@ -30,10 +29,9 @@ void PlayerWeapon::update(double dt) {
 	animSprite.update(dt);
 }
 
-void PlayerWeapon::draw(sf::RenderWindow& win) {
-	if (!player.isGameInEditor) drawLaser(win);
-	animSprite.draw(&win);
-	for (Bullet& b : bullets) win.draw(b.sprite);
+void PlayerWeapon::draw(sf::RenderWindow& win, const sf::RenderStates& states) {
+	if (!player.isGameInEditor) drawLaser(win, states);
+	animSprite.draw(&win, states);
 }
 
 void PlayerWeapon::loadAnimations() {
@@ -123,48 +121,41 @@ sf::Vector2f PlayerWeapon::getFirePos() {
 	return firePos;
 }
 
+// a projectile, or a hitscan shot resolved at the end of the tick
 void PlayerWeapon::generateBullet(sf::Vector2f firePos) {
 	float rAngle = aimedAngle + randf(-4.0f, 4.0f);
-	Bullet newBullet(bulletTex, firePos, rAngle);
-	player.wallMap.bullets.push_back(newBullet);
+	if (isHitscan) player.wallMap.fireHitscan(firePos, rAngle);
+	else player.wallMap.bullets.spawn(firePos, rAngle, BulletPool::PlayerOwner);
 }
 
+// every tick, see Bench::laser for the cost of getLaserLen
 void PlayerWeapon::updateLaser() {
-	frameCounter++;
-	if (frameCounter >= framesPerUpdate) {
-		frameCounter = 0;
-		int ofstArr[]{ 0, -1, -2, -1, 0 };
-		float ofst = (animSprite.current == &animSprite.animations[Wait]) ? ofstArr[animSprite.current->curr] : 0;
-		sf::Vector2f lasPos = getFirePos() - ((getForward(aimedAngle) * 20.0f) + ((getUp(aimedAngle) * ofst * (float)getSense())));
-		laser.setSize({ getLaserLen(lasPos, aimedAngle, 2000.0f), thickness });
-		laser.setRotation(aimedAngle);
-		laser.setPosition(lasPos);
-	}
+	int ofstArr[]{ 0, -1, -2, -1, 0 };
+	float ofst = (animSprite.current == &animSprite.animations[Wait]) ? ofstArr[animSprite.current->curr] : 0;
+	sf::Vector2f lasPos = getFirePos() - ((getForward(aimedAngle) * 20.0f) + ((getUp(aimedAngle) * ofst * (float)getSense())));
+	laser.setSize({ getLaserLen(lasPos, aimedAngle, 2000.0f), thickness });
+	laser.setRotation(aimedAngle);
+	laser.setPosition(lasPos);
 }
 
-void PlayerWeapon::drawLaser(sf::RenderWindow& win) {
-	win.draw(laser);
+void PlayerWeapon::drawLaser(sf::RenderWindow& win, const sf::RenderStates& states) {
+	win.draw(laser, states);
 }
 
+// Exact distance to the first wall (grid DDA) or live enemy (slab test on
+// the enemies along the segment only)
 float PlayerWeapon::getLaserLen(sf::Vector2f& start, float angleDeg, float maxLen)
 {
+	WallMap& wallMap = player.wallMap;
 	sf::Vector2f dir = getForward(angleDeg);
-	float step = 20.0f;
-	float dist = 0.0f;
-
-	while (dist < maxLen)
-	{
-		sf::Vector2f actualPos = start + (dir * dist);
-		int cx = int(actualPos.x / C::GRID_SIZE);
-		int cy = int(actualPos.y / C::GRID_SIZE);
-		if (player.wallMap.isWall(cx,cy))                 
-			return dist;
-
-		for (Enemy& e : player.wallMap.enemies)
-			if (!e.isDead && e.vBox.contains(actualPos))
-				return dist;
-
-		dist += step;
+	float len = wallMap.raycast(start, dir, maxLen).dist;
+
+	float t;
+	wallMap.enemyIndex.querySegment(start, start + dir * len, wallMap.queryIds);
+	for (int i : wallMap.queryIds) {
+		Enemy& e = wallMap.enemies[i];
+		if (!e.isDead && rayIntersectsRect(start, dir, e.vBox, len, t))
+			len = t;
 	}
-	return maxLen;
+	return len;
 }
\ No newline at end of file
@@ -5,7 +5,6 @@
 
 #include "AnimatedSprite.h"
 #include"EffectsManager.h"
-#include "Bullet.h"
 
 class Player;
 
@@ -29,20 +28,16 @@ public:
 	float reloadTime = 0.1f;
 	float reloadTimer = 0.0f;
 	bool canShoot = true;
+	bool isHitscan = false;
 	bool hasPlayerSwitchFromIdle = true;
 	bool hasWeaponSwitchFromWait = false;
 
-	sf::Texture bulletTex;
-	std::vector<Bullet> bullets;
-
 	sf::RectangleShape laser;
 	float thickness = 3.0f;
-	int framesPerUpdate = 5;
-	int frameCounter = 0;
 
 	PlayerWeapon(Player& pPlayer, const std::string& pTexPath, sf::Vector2i pFrameSize);
 	void update(double dt);
-	void draw(sf::RenderWindow& win);
+	void draw(sf::RenderWindow& win, const sf::RenderStates& states = sf::RenderStates::Default);
 	void loadAnimations();
 	void updatePosition(double dt);
 	void updateAnimations(double dt);
@@ -56,7 +51,7 @@ public:
 	void playShootEffect(sf::Vector2f firePos);
 	void generateBullet(sf::Vector2f firePos);
 	void updateLaser();
-	void drawLaser(sf::RenderWindow& win);
+	void drawLaser(sf::RenderWindow& win, const sf::RenderStates& states);
 	float getLaserLen(sf::Vector2f& start, float angleDeg, float maxLen);
 };
 
@@ -5,9 +5,9 @@ Pointer::Pointer(sf::RenderWindow& pWin) : win(pWin) {
 
 }
 
-void Pointer::update(double dt) {
-	winPos = sf::Mouse::getPosition(win);
-	worldPos = win.mapPixelToCoords(winPos);
+void Pointer::update(const InputState& input) {
+	worldPos = input.aim;
+	winPos = win.mapCoordsToPixel(worldPos);
 }
 
 void Pointer::draw() {
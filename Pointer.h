@@ -5,6 +5,7 @@
 
 #include "AnimatedSprite.h"
 #include "C.hpp"
+#include "Input.h"
 
 class Pointer
 {
@@ -21,7 +22,7 @@ public:
 	//AnimatedSprite<PointerType> animSprite;
 
 	Pointer(sf::RenderWindow& pWin);
-	void update(double dt);
+	void update(const InputState& input);
 	void draw();
 };
 
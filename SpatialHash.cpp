@@ -0,0 +1,116 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "SpatialHash.h"
+#include "C.hpp"
+
+SpatialHash::SpatialHash(float pCellSize, int pBucketBits) : cellSize(pCellSize) {
+	buckets.resize((size_t)1 << pBucketBits);
+	bucketMask = (int)buckets.size() - 1;
+}
+
+void SpatialHash::clear() {
+	for (int b : usedBuckets) buckets[b].clear();
+	usedBuckets.clear();
+}
+
+int SpatialHash::toCell(float v) const {
+	return (int)std::floor(v / cellSize);
+}
+
+int SpatialHash::getBucket(int cx, int cy) const {
+	uint32_t h = (uint32_t)cx * 73856093u ^ (uint32_t)cy * 19349663u;
+	return (int)(h & (uint32_t)bucketMask);
+}
+
+void SpatialHash::insert(int id, const sf::FloatRect& box) {
+	if (id >= (int)boxes.size()) {
+		boxes.resize(id + 1);
+		stamps.resize(id + 1, 0);
+	}
+	boxes[id] = box;
+
+	int x0 = toCell(box.left);
+	int x1 = toCell(box.left + box.width);
+	int y0 = toCell(box.top);
+	int y1 = toCell(box.top + box.height);
+	for (int cy = y0; cy <= y1; cy++)
+		for (int cx = x0; cx <= x1; cx++) {
+			int b = getBucket(cx, cy);
+			if (buckets[b].empty()) usedBuckets.push_back(b);
+			buckets[b].push_back(id);
+		}
+}
+
+// ids already seen by the running query carry the current stamp
+void SpatialHash::nextStamp() {
+	if (++stamp == 0) {
+		std::fill(stamps.begin(), stamps.end(), 0);
+		stamp = 1;
+	}
+}
+
+void SpatialHash::query(const sf::FloatRect& box, std::vector<int>& out) {
+	out.clear();
+	nextStamp();
+
+	int x0 = toCell(box.left);
+	int x1 = toCell(box.left + box.width);
+	int y0 = toCell(box.top);
+	int y1 = toCell(box.top + box.height);
+	for (int cy = y0; cy <= y1; cy++)
+		for (int cx = x0; cx <= x1; cx++)
+			for (int id : buckets[getBucket(cx, cy)]) {
+				if (stamps[id] == stamp) continue;
+				stamps[id] = stamp;
+				if (boxes[id].intersects(box)) out.push_back(id);
+			}
+}
+
+void SpatialHash::queryPoint(sf::Vector2f p, float radius, std::vector<int>& out) {
+	query({ p.x - radius, p.y - radius, radius * 2.0f, radius * 2.0f }, out);
+}
+
+// Walks the cells the segment crosses (DDA), since every object is stored
+// in each cell its bounds overlap.
+void SpatialHash::querySegment(sf::Vector2f a, sf::Vector2f b, std::vector<int>& out) {
+	out.clear();
+	nextStamp();
+
+	sf::Vector2f d = b - a;
+	float length = std::sqrt(d.x * d.x + d.y * d.y);
+	sf::Vector2f dir = normalize(d);
+	float t;
+	int cx = toCell(a.x);
+	int cy = toCell(a.y);
+	int endX = toCell(b.x);
+	int endY = toCell(b.y);
+	int stepX = (d.x > 0.0f) ? 1 : -1;
+	int stepY = (d.y > 0.0f) ? 1 : -1;
+	const float inf = std::numeric_limits<float>::infinity();
+	float tDeltaX = (d.x != 0.0f) ? std::abs(cellSize / d.x) : inf;
+	float tDeltaY = (d.y != 0.0f) ? std::abs(cellSize / d.y) : inf;
+	float tMaxX = (d.x != 0.0f) ? ((cx + (stepX > 0 ? 1 : 0)) * cellSize - a.x) / d.x : inf;
+	float tMaxY = (d.y != 0.0f) ? ((cy + (stepY > 0 ? 1 : 0)) * cellSize - a.y) / d.y : inf;
+
+	int cellCount = std::abs(endX - cx) + std::abs(endY - cy) + 1;
+	for (int n = 0; n < cellCount; n++) {
+		for (int id : buckets[getBucket(cx, cy)]) {
+			if (stamps[id] == stamp) continue;
+			stamps[id] = stamp;
+			// EPS keeps the segments grazing a corner, lost to rounding dir
+			const sf::FloatRect& r = boxes[id];
+			sf::FloatRect box = { r.left - C::EPS, r.top - C::EPS, r.width + C::EPS * 2.0f, r.height + C::EPS * 2.0f };
+			if (rayIntersectsRect(a, dir, box, length, t)) out.push_back(id);
+		}
+		if (tMaxX < tMaxY) {
+			tMaxX += tDeltaX;
+			cx += stepX;
+		}
+		else {
+			tMaxY += tDeltaY;
+			cy += stepY;
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+
+// Uniform grid of cellSize buckets hashed into a fixed power of two table.
+// Objects are inserted by integer id with their bounds, and queries return
+// each id overlapping the query rect, point or segment once, unsorted.
+class SpatialHash
+{
+public:
+	float cellSize;
+	int bucketMask;
+	std::vector<std::vector<int>> buckets;
+	std::vector<int> usedBuckets;
+	std::vector<sf::FloatRect> boxes;
+	std::vector<uint32_t> stamps;
+	uint32_t stamp = 0;
+
+	SpatialHash(float pCellSize = 256.0f, int pBucketBits = 10);
+	void clear();
+	void insert(int id, const sf::FloatRect& box);
+	void query(const sf::FloatRect& box, std::vector<int>& out);
+	void queryPoint(sf::Vector2f p, float radius, std::vector<int>& out);
+	void querySegment(sf::Vector2f a, sf::Vector2f b, std::vector<int>& out);
+	int getBucket(int cx, int cy) const;
+	int toCell(float v) const;
+
+private:
+	void nextStamp();
+};
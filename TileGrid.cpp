@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstring>
+
+#include "TileGrid.h"
+
+void TileGrid::set(int x, int y, uint8_t id) {
+	Chunk* c = getChunk(toChunk(x), toChunk(y));
+	if (c == nullptr) {
+		if (id == EMPTY) return;
+		c = &ensureChunk(toChunk(x), toChunk(y));
+	}
+	uint8_t& cell = c->ids[toLocal(x, y)];
+	int lx = x & CHUNK_MASK;
+	int ly = y & CHUNK_MASK;
+	if (cell == EMPTY && id != EMPTY) {
+		c->count++;
+		c->rowBits[ly] |= 1u << lx;
+		c->colBits[lx] |= 1u << ly;
+	}
+	else if (cell != EMPTY && id == EMPTY) {
+		c->count--;
+		c->rowBits[ly] &= ~(1u << lx);
+		c->colBits[lx] &= ~(1u << ly);
+	}
+	else {
+		cell = id;
+		return;
+	}
+	cell = id;
+
+	for (int j = -1; j <= 1; j++)
+		for (int i = -1; i <= 1; i++) {
+			uint16_t bit = navBit(-i, -j);
+			uint16_t nav = getNav(x + i, y + j);
+			storeNav(x + i, y + j, (id != EMPTY) ? (nav | bit) : (nav & ~bit));
+		}
+	updateFloorAbove(x, y);
+}
+
+void TileGrid::setChunk(int cx, int cy, const uint8_t* ids) {
+	Chunk& c = ensureChunk(cx, cy);
+	std::memcpy(c.ids.data(), ids, CHUNK_CELLS);
+	c.count = 0;
+	c.rowBits.fill(0);
+	c.colBits.fill(0);
+	for (int i = 0; i < CHUNK_CELLS; i++) {
+		if (c.ids[i] == EMPTY) continue;
+		int lx = i & CHUNK_MASK;
+		int ly = i >> CHUNK_SHIFT;
+		c.count++;
+		c.rowBits[ly] |= 1u << lx;
+		c.colBits[lx] |= 1u << ly;
+	}
+
+	int x0 = cx * CHUNK_SIZE;
+	int y0 = cy * CHUNK_SIZE;
+	for (int y = y0 - 1; y <= y0 + CHUNK_SIZE; y++)
+		for (int x = x0 - 1; x <= x0 + CHUNK_SIZE; x++)
+			storeNav(x, y, computeNav(x, y));
+
+	for (int x = x0; x < x0 + CHUNK_SIZE; x++) {
+		for (int y = y0 + CHUNK_SIZE - 1; y >= y0; y--)
+			storeFloorDist(x, y, computeFloorDist(x, y));
+		updateFloorAbove(x, y0);
+	}
+}
+
+uint16_t TileGrid::computeNav(int x, int y) const {
+	uint16_t nav = 0;
+	for (int j = -1; j <= 1; j++)
+		for (int i = -1; i <= 1; i++)
+			if (get(x + i, y + j) != EMPTY) nav |= navBit(i, j);
+	return nav;
+}
+
+uint8_t TileGrid::computeFloorDist(int x, int y) const {
+	if (get(x, y + 1) != EMPTY) return 0;
+	uint8_t below = getFloorDist(x, y + 1);
+	return (below >= MAX_FLOOR_DIST) ? NO_FLOOR : below + 1;
+}
+
+// derived values are only stored in allocated chunks, a missing chunk
+// reads as the defaults (no neighbour, no floor)
+void TileGrid::storeNav(int x, int y, uint16_t nav) {
+	Chunk* c = getChunk(toChunk(x), toChunk(y));
+	if (c == nullptr) {
+		if (nav == 0) return;
+		c = &ensureChunk(toChunk(x), toChunk(y));
+	}
+	c->nav[toLocal(x, y)] = nav;
+}
+
+bool TileGrid::storeFloorDist(int x, int y, uint8_t dist) {
+	Chunk* c = getChunk(toChunk(x), toChunk(y));
+	if (c == nullptr) {
+		if (dist == NO_FLOOR) return false;
+		c = &ensureChunk(toChunk(x), toChunk(y));
+	}
+	uint8_t& cell = c->floorDist[toLocal(x, y)];
+	bool changed = cell != dist;
+	cell = dist;
+	return changed;
+}
+
+// floorDist only depends on the cells below, so an edit at (x, y) can only
+// change the column above it, up to the first unchanged cell
+void TileGrid::updateFloorAbove(int x, int y) {
+	for (int k = y - 1; k >= y - MAX_FLOOR_DIST - 1; k--)
+		if (!storeFloorDist(x, k, computeFloorDist(x, k))) break;
+}
+
+TileGrid::Chunk& TileGrid::ensureChunk(int cx, int cy) {
+	growTo(cx, cy);
+	std::unique_ptr<Chunk>& slot = chunks[(cy - chunkY0) * chunkCols + (cx - chunkX0)];
+	if (!slot) slot = std::make_unique<Chunk>();
+	return *slot;
+}
+
+// Frees the chunk storage, the directory keeps its size. The released
+// cells read as EMPTY from now on, so the one-cell ring of nav around the
+// chunk and the floorDist of the columns above are recomputed, as
+// setChunk does, in the chunks still allocated.
+void TileGrid::releaseChunk(int cx, int cy) {
+	int ix = cx - chunkX0;
+	int iy = cy - chunkY0;
+	if ((unsigned)ix >= (unsigned)chunkCols || (unsigned)iy >= (unsigned)chunkRows) return;
+	std::unique_ptr<Chunk>& slot = chunks[iy * chunkCols + ix];
+	if (!slot) return;
+	slot.reset();
+
+	int x0 = cx * CHUNK_SIZE;
+	int y0 = cy * CHUNK_SIZE;
+	for (int y = y0 - 1; y <= y0 + CHUNK_SIZE; y++)
+		for (int x = x0 - 1; x <= x0 + CHUNK_SIZE; x++) {
+			bool isRing = x < x0 || x >= x0 + CHUNK_SIZE || y < y0 || y >= y0 + CHUNK_SIZE;
+			if (isRing && getChunk(toChunk(x), toChunk(y)) != nullptr) storeNav(x, y, computeNav(x, y));
+		}
+	for (int x = x0; x < x0 + CHUNK_SIZE; x++)
+		updateFloorAbove(x, y0);
+}
+
+void TileGrid::growTo(int cx, int cy) {
+	if (chunkCols == 0) {
+		chunkX0 = cx;
+		chunkY0 = cy;
+		chunkCols = 1;
+		chunkRows = 1;
+		chunks.resize(1);
+		return;
+	}
+
+	int nx0 = std::min(chunkX0, cx);
+	int ny0 = std::min(chunkY0, cy);
+	int nx1 = std::max(chunkX0 + chunkCols - 1, cx);
+	int ny1 = std::max(chunkY0 + chunkRows - 1, cy);
+	int nCols = nx1 - nx0 + 1;
+	int nRows = ny1 - ny0 + 1;
+	if (nCols == chunkCols && nRows == chunkRows) return;
+
+	std::vector<std::unique_ptr<Chunk>> grown(nCols * nRows);
+	for (int y = 0; y < chunkRows; y++)
+		for (int x = 0; x < chunkCols; x++)
+			grown[(y + chunkY0 - ny0) * nCols + (x + chunkX0 - nx0)] = std::move(chunks[y * chunkCols + x]);
+
+	chunks = std::move(grown);
+	chunkX0 = nx0;
+	chunkY0 = ny0;
+	chunkCols = nCols;
+	chunkRows = nRows;
+}
+
+void TileGrid::clear() {
+	chunks.clear();
+	chunkX0 = 0;
+	chunkY0 = 0;
+	chunkCols = 0;
+	chunkRows = 0;
+}
+
+int TileGrid::getAllocatedChunks() const {
+	int n = 0;
+	for (const std::unique_ptr<Chunk>& c : chunks) if (c) n++;
+	return n;
+}
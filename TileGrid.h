@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Dense tile storage split in CHUNK_SIZE x CHUNK_SIZE chunks of one-byte IDs.
+// Chunks are allocated on demand and indexed through a dense directory,
+// so a lookup is two array reads and never hashes.
+// Each chunk also keeps its occupancy as one bit per cell, packed by row
+// and by column, to answer span queries a 32-cell word at a time.
+// Derived per-cell data is kept up to date on every edit: nav holds the
+// occupancy of the 3x3 neighbourhood (see navBit) and floorDist the number
+// of empty cells down to the first solid one.
+class TileGrid
+{
+public:
+	static constexpr int CHUNK_SHIFT = 5;
+	static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+	static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+	static constexpr int CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+	static constexpr uint8_t EMPTY = 0;
+	static constexpr uint8_t MAX_FLOOR_DIST = 32;
+	static constexpr uint8_t NO_FLOOR = 255;
+
+	struct Chunk {
+		Chunk() { floorDist.fill(NO_FLOOR); }
+		std::array<uint8_t, CHUNK_CELLS> ids{};
+		std::array<int32_t, CHUNK_CELLS> slots{};
+		std::array<uint32_t, CHUNK_SIZE> rowBits{};
+		std::array<uint32_t, CHUNK_SIZE> colBits{};
+		std::array<uint16_t, CHUNK_CELLS> nav{};
+		std::array<uint8_t, CHUNK_CELLS> floorDist;
+		int count = 0;
+	};
+
+	int chunkX0 = 0;
+	int chunkY0 = 0;
+	int chunkCols = 0;
+	int chunkRows = 0;
+	std::vector<std::unique_ptr<Chunk>> chunks;
+
+	uint8_t get(int x, int y) const;
+	void set(int x, int y, uint8_t id);
+	void setChunk(int cx, int cy, const uint8_t* ids);
+	int32_t getSlot(int x, int y) const;
+	void setSlot(int x, int y, int32_t slot);
+	bool anyInRow(int y, int x0, int x1) const;
+	bool anyInCol(int x, int y0, int y1) const;
+	uint16_t getNav(int x, int y) const;
+	uint8_t getFloorDist(int x, int y) const;
+	Chunk* getChunk(int cx, int cy) const;
+	Chunk& ensureChunk(int cx, int cy);
+	void releaseChunk(int cx, int cy);
+	void clear();
+	int getAllocatedChunks() const;
+
+	static int toChunk(int v) { return v >> CHUNK_SHIFT; }
+	static int toLocal(int x, int y) { return ((y & CHUNK_MASK) << CHUNK_SHIFT) | (x & CHUNK_MASK); }
+	static uint32_t spanMask(int lo, int hi) { return (0xFFFFFFFFu >> (CHUNK_MASK - hi)) & (0xFFFFFFFFu << lo); }
+	static uint16_t navBit(int ox, int oy) { return (uint16_t)(1u << ((oy + 1) * 3 + (ox + 1))); }
+
+private:
+	void growTo(int cx, int cy);
+	uint16_t computeNav(int x, int y) const;
+	uint8_t computeFloorDist(int x, int y) const;
+	void storeNav(int x, int y, uint16_t nav);
+	bool storeFloorDist(int x, int y, uint8_t dist);
+	void updateFloorAbove(int x, int y);
+};
+
+inline TileGrid::Chunk* TileGrid::getChunk(int cx, int cy) const {
+	cx -= chunkX0;
+	cy -= chunkY0;
+	if ((unsigned)cx >= (unsigned)chunkCols || (unsigned)cy >= (unsigned)chunkRows) return nullptr;
+	return chunks[cy * chunkCols + cx].get();
+}
+
+inline uint8_t TileGrid::get(int x, int y) const {
+	const Chunk* c = getChunk(toChunk(x), toChunk(y));
+	return c ? c->ids[toLocal(x, y)] : EMPTY;
+}
+
+inline int32_t TileGrid::getSlot(int x, int y) const {
+	const Chunk* c = getChunk(toChunk(x), toChunk(y));
+	return c ? c->slots[toLocal(x, y)] : -1;
+}
+
+inline void TileGrid::setSlot(int x, int y, int32_t slot) {
+	Chunk* c = getChunk(toChunk(x), toChunk(y));
+	if (c) c->slots[toLocal(x, y)] = slot;
+}
+
+inline bool TileGrid::anyInRow(int y, int x0, int x1) const {
+	if (x1 < x0) return false;
+	int cy = toChunk(y);
+	int ly = y & CHUNK_MASK;
+	int cx0 = toChunk(x0);
+	int cx1 = toChunk(x1);
+	for (int cx = cx0; cx <= cx1; cx++) {
+		const Chunk* c = getChunk(cx, cy);
+		if (c == nullptr) continue;
+		int lo = (cx == cx0) ? (x0 & CHUNK_MASK) : 0;
+		int hi = (cx == cx1) ? (x1 & CHUNK_MASK) : CHUNK_MASK;
+		if (c->rowBits[ly] & spanMask(lo, hi)) return true;
+	}
+	return false;
+}
+
+inline bool TileGrid::anyInCol(int x, int y0, int y1) const {
+	if (y1 < y0) return false;
+	int cx = toChunk(x);
+	int lx = x & CHUNK_MASK;
+	int cy0 = toChunk(y0);
+	int cy1 = toChunk(y1);
+	for (int cy = cy0; cy <= cy1; cy++) {
+		const Chunk* c = getChunk(cx, cy);
+		if (c == nullptr) continue;
+		int lo = (cy == cy0) ? (y0 & CHUNK_MASK) : 0;
+		int hi = (cy == cy1) ? (y1 & CHUNK_MASK) : CHUNK_MASK;
+		if (c->colBits[lx] & spanMask(lo, hi)) return true;
+	}
+	return false;
+}
+
+inline uint16_t TileGrid::getNav(int x, int y) const {
+	const Chunk* c = getChunk(toChunk(x), toChunk(y));
+	return c ? c->nav[toLocal(x, y)] : 0;
+}
+
+inline uint8_t TileGrid::getFloorDist(int x, int y) const {
+	const Chunk* c = getChunk(toChunk(x), toChunk(y));
+	return c ? c->floorDist[toLocal(x, y)] : NO_FLOOR;
+}
@@ -1,44 +1,243 @@
+#include <limits>
+#include <climits>
+#include <cstdio>
+
 #include "WallMap.h"
 #include "EffectsManager.h"
+#include "Lib.hpp"
 
 WallMap::WallMap(sf::RenderWindow& pWin, Player& pPlayer) : win(pWin), player(pPlayer) {
 	camera = win.getView();
+	prevCameraCenter = camera.getCenter();
 	loadBackgrounds();
 	loadWallTextures();
+	bullets.loadTexture("res/sprites/bullet.png");
+	meshSubscriber = changes.subscribe();
+	lodSubscriber = changes.subscribe();
+	losSubscriber = changes.subscribe();
+	navSubscriber = changes.subscribe();
 	buildMap();
-	loadEnnemies();
-}
-
-WallMap::Wall::Wall(uint64_t pKey, WallType pType, std::unordered_map<WallType, sf::Texture>& pTextures) : key(pKey), type(pType) {
-	sprite.setTexture(pTextures[pType]);
-	sf::Vector2i pos = getVec2i(pKey);
-	sprite.setPosition((float)pos.x * C::GRID_SIZE, (float)pos.y * C::GRID_SIZE);
 }
 
+// the edits of the last tick are committed first, so every consumer reads
+// the same versions whether frames are drawn or not
 void WallMap::update(double dt) {
+	changes.commit();
 	updateBackgrounds();
 	updateCamera(dt);
-	for (Enemy& e : enemies) e.update(dt);
-	for (int i = bullets.size() - 1; i >= 0; i--) {
-		Bullet& b = bullets[i];
-		b.update(dt);
-		if (b.checkCollision(player, *this, win.getView().getCenter())) bullets.erase(bullets.begin() + i);
+	streamAround(camera.getCenter(), isStreamingBlocking);
+	resolveLineOfSight();
+	updateNavigation();
+	updateEnemies(dt);
+	updateEnemyPhysics(dt);
+	indexEnemies();
+	resolveHitscan();
+	bullets.move(dt);
+	for (int i = 0; i < bullets.size();) {
+		if (bullets.checkCollision(i, *this, camera.getCenter())) bullets.remove(i);
+		else i++;
+	}
+	indexBullets();
+}
+
+// start of a simulation tick, see Game::update
+void WallMap::savePrevState() {
+	prevCameraCenter = camera.getCenter();
+	for (Enemy& e : enemies) e.savePrevPos();
+	bullets.savePrevPos();
+}
+
+// FNV-1a over the state a replay has to reproduce: player, enemies and
+// bullets, in order
+uint64_t WallMap::getStateChecksum() const {
+	uint64_t h = 14695981039346656037ull;
+	auto mix = [&h](const void* data, size_t size) {
+		const uint8_t* bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++) {
+			h ^= bytes[i];
+			h *= 1099511628211ull;
+		}
+	};
+	auto mixEntity = [&mix](const Entity& e) {
+		const float f[] = { e.pos.x, e.pos.y, e.dx, e.dy, e.addedX, e.addedY };
+		const int32_t i[] = { e.life, e.isDead };
+		mix(f, sizeof(f));
+		mix(i, sizeof(i));
+	};
+
+	mixEntity(player);
+	int32_t count = (int32_t)enemies.size();
+	mix(&count, sizeof(count));
+	for (const Enemy& e : enemies) mixEntity(e);
+	count = (int32_t)bullets.size();
+	mix(&count, sizeof(count));
+	mix(bullets.posX.data(), count * sizeof(float));
+	mix(bullets.posY.data(), count * sizeof(float));
+	return h;
+}
+
+// Brings the nav graph up to date with the tile edits and chunk loads of
+// the last frame, then points the chase flow at the span the player stands
+// on (kept while the player is in the air).
+void WallMap::updateNavigation() {
+	double start = Lib::getTimeStamp();
+	bool isChanged = true;
+	if (!changes.pull(navSubscriber, changedCells)) nav.build(tileGrid);
+	else if (changedCells.empty()) isChanged = false;
+	else for (const sf::IntRect& r : changedCells) nav.rebuild(tileGrid, r);
+	if (isChanged) {
+		nav.lastBuildTime = Lib::getTimeStamp() - start;
+		playerNavNode = -1;
+	}
+
+	sf::Vector2i cell = NavGraph::getStandingCell(player.vBox, (float)C::GRID_SIZE);
+	int node = nav.findNode(cell.x, cell.y);
+	if (node >= 0) playerNavNode = node;
+	nav.updateFlow(playerNavNode);
+}
+
+// Enemies think in parallel, each writing only its own state, then apply
+// their side effects (bullets, effects, recoil) one by one in index order,
+// so the outcome is the same as a serial update whatever the thread count.
+void WallMap::updateEnemies(double dt) {
+	double start = Lib::getTimeStamp();
+	scheduleEnemies(dt);
+	jobs.parallelFor((int)enemies.size(), thinkGrain, [&](int begin, int end) {
+		for (int i = begin; i < end; i++)
+			if (enemies[i].thinkDt > 0.0) enemies[i].think(enemies[i].thinkDt);
+	});
+	for (Enemy& e : enemies)
+		if (!e.isStreamedOut) e.apply();
+	thinkTime = Lib::getTimeStamp() - start;
+}
+
+// Sets each enemy's thinkDt for this tick. Enemies within aiFullRadius,
+// awake or aware of the player think every tick with dt, exactly as
+// without LOD. Reduced ones bank dt and think with the sum every
+// aiReducedStep; sleeping ones stop where they are.
+void WallMap::scheduleEnemies(double dt) {
+	wakeEnemiesNearEdits();
+	aiLodStats = {};
+	float fullSq = aiFullRadius * aiFullRadius;
+	float sleepSq = aiSleepRadius * aiSleepRadius;
+	for (Enemy& e : enemies) {
+		e.thinkDt = 0.0;
+		if (e.isStreamedOut) continue;
+
+		float distSq = getDistanceSquared(e.pos, player.pos);
+		bool isAwake = e.wakeTimer > 0.0 || e.hasSeenPlayer || e.isTakingDamage;
+		e.wakeTimer = std::max(0.0, e.wakeTimer - dt);
+
+		Enemy::AiLod lod = Enemy::LodFull;
+		if (isAiLodEnabled && !isAwake && distSq > fullSq)
+			lod = (distSq > sleepSq) ? Enemy::LodAsleep : Enemy::LodReduced;
+
+		if (lod == Enemy::LodFull) {
+			e.thinkDt = dt;
+			e.lodTimer = 0.0;
+			aiLodStats.full++;
+		}
+		else if (lod == Enemy::LodReduced) {
+			e.lodTimer += dt;
+			if (e.lodTimer >= aiReducedStep) {
+				e.thinkDt = e.lodTimer;
+				e.lodTimer = 0.0;
+			}
+			aiLodStats.reduced++;
+		}
+		else {
+			if (e.aiLod != Enemy::LodAsleep) e.dx = 0.0f;
+			e.lodTimer = 0.0;
+			aiLodStats.asleep++;
+		}
+		e.aiLod = lod;
+		if (e.thinkDt > 0.0) aiLodStats.thinking++;
+	}
+}
+
+// edited cells wake the enemies around them, a full reset wakes them all
+void WallMap::wakeEnemiesNearEdits() {
+	if (!changes.pull(lodSubscriber, lodCells)) {
+		for (Enemy& e : enemies) e.wakeTimer = aiWakeTime;
+		return;
+	}
+	const float g = (float)C::GRID_SIZE;
+	for (const sf::IntRect& r : lodCells) {
+		sf::FloatRect area = { r.left * g - aiWakeMargin, r.top * g - aiWakeMargin,
+			r.width * g + aiWakeMargin * 2.0f, r.height * g + aiWakeMargin * 2.0f };
+		enemyIndex.query(area, queryIds);
+		for (int i : queryIds) enemies[i].wakeTimer = aiWakeTime;
+	}
+}
+
+// enemies move together through the SoA world
+void WallMap::updateEnemyPhysics(double dt) {
+	int n = (int)enemies.size();
+	int shaped = std::min(physics.size(), n);
+	physics.resize(n);
+	for (int i = shaped; i < n; i++) physics.setShape(i, enemies[i]);
+
+	for (int i = 0; i < n; i++) {
+		if (enemies[i].isStreamedOut) physics.flags[i] = 0;
+		else physics.gather(i, enemies[i]);
+	}
+	physics.step(dt, tileGrid);
+	for (int i = 0; i < n; i++) {
+		if (enemies[i].isStreamedOut) continue;
+		physics.scatter(i, enemies[i]);
+		enemies[i].updateAfterPhysics(dt);
 	}
 }
 
 void WallMap::draw() {
+	sf::View renderView = camera;
+	renderView.setCenter(prevCameraCenter + (camera.getCenter() - prevCameraCenter) * renderAlpha);
+	win.setView(renderView);
 	drawBackgrounds();
-	for (Wall& r : walls) win.draw(r.sprite);
-	for (Enemy& e : enemies) e.draw(win);
-	for (Bullet& b : bullets) b.draw(win);
+	sf::FloatRect view = getViewRect(cullMargin);
+	drawWalls(view);
+
+	enemyIndex.query(view, visibleIds);
+	std::sort(visibleIds.begin(), visibleIds.end());
+	for (int i : visibleIds) {
+		enemies[i].setRenderAlpha(renderAlpha);
+		enemies[i].draw(win);
+	}
+	renderStats.enemiesDrawn = (int)visibleIds.size();
+	renderStats.enemiesCulled = (int)enemies.size() - renderStats.enemiesDrawn;
+
+	bulletIndex.query(view, visibleIds);
+	std::sort(visibleIds.begin(), visibleIds.end());
+	bullets.draw(win, visibleIds, renderAlpha);
+	renderStats.bulletsDrawn = (int)visibleIds.size();
+	renderStats.bulletsCulled = (int)bullets.size() - renderStats.bulletsDrawn;
+	renderStats.bulletDrawCalls = visibleIds.empty() ? 0 : 1;
+}
+
+sf::FloatRect WallMap::getViewRect(float margin) {
+	const sf::View& v = win.getView();
+	sf::Vector2f size = v.getSize();
+	sf::Vector2f topLeft = v.getCenter() - (size * 0.5f);
+	return { topLeft.x - margin, topLeft.y - margin, size.x + margin * 2.0f, size.y + margin * 2.0f };
+}
+
+void WallMap::indexEnemies() {
+	enemyIndex.clear();
+	for (int i = 0; i < (int)enemies.size(); i++)
+		if (!enemies[i].isStreamedOut) enemyIndex.insert(i, enemies[i].vBox);
+}
+
+void WallMap::indexBullets() {
+	bulletIndex.clear();
+	for (int i = 0; i < bullets.size(); i++)
+		bulletIndex.insert(i, bullets.getBounds(i));
 }
 
 void WallMap::updateCamera(double dt) {
-	camera = win.getView();
 	sf::Vector2f target = { player.pos.x, C::RES_Y / 2 };
 	sf::Vector2f camPos = lerpVec(camera.getCenter(), target, 0.005f, dt);
-	if (camPos.x <= C::RES_X / 2) camPos.x = C::RES_X / 2;
-	else if (camPos.x >= C::RES_X * 2.5) camPos.x = C::RES_X * 2.5;
+	if (camPos.x <= cameraMinX) camPos.x = cameraMinX;
+	else if (camPos.x >= cameraMaxX) camPos.x = cameraMaxX;
 	camera.setCenter(camPos);
 	updateShake(dt);
 	win.setView(camera);
@@ -64,19 +263,85 @@ void WallMap::shakeCamera(float duration, float strength) {
 }
 
 void WallMap::loadWallTextures() {
-	wallTextures.reserve(3);
-	wallTextures[WallType::Ground].loadFromFile("res/sprites/ground.png");
-	wallTextures[WallType::Edge1].loadFromFile("res/sprites/edge1.png");
-	wallTextures[WallType::Edge2].loadFromFile("res/sprites/edge2.png");
-	wallTextures[WallType::Angle1].loadFromFile("res/sprites/angle1.png");
-	wallTextures[WallType::Angle2].loadFromFile("res/sprites/angle2.png");
-	wallTextures[WallType::Dirt].loadFromFile("res/sprites/dirt.png");
-	wallTextures[WallType::Box].loadFromFile("res/sprites/box.png");
+	const std::pair<WallType, std::string> paths[] = {
+		{ WallType::Ground, "res/sprites/ground.png" },
+		{ WallType::Edge1, "res/sprites/edge1.png" },
+		{ WallType::Edge2, "res/sprites/edge2.png" },
+		{ WallType::Angle1, "res/sprites/angle1.png" },
+		{ WallType::Angle2, "res/sprites/angle2.png" },
+		{ WallType::Dirt, "res/sprites/dirt.png" },
+		{ WallType::Box, "res/sprites/box.png" }
+	};
+
+	// one atlas column per WallType, so a tile's u offset is type * GRID_SIZE
+	sf::Image atlas;
+	atlas.create(C::GRID_SIZE * (WallType::Box + 1), C::GRID_SIZE, sf::Color::Transparent);
+	for (const auto& [type, path] : paths) {
+		sf::Image img;
+		if (!img.loadFromFile(path)) { std::cout << "WALL TEXTURE LOAD ERROR, path : " << path << std::endl; continue; }
+		atlas.copy(img, type * C::GRID_SIZE, 0);
+	}
+	wallAtlas.loadFromImage(atlas);
+}
+
+void WallMap::drawWalls(const sf::FloatRect& view) {
+	const float chunkPx = (float)(TileGrid::CHUNK_SIZE * C::GRID_SIZE);
+	int cx0 = std::max((int)std::floor(view.left / chunkPx), tileGrid.chunkX0);
+	int cy0 = std::max((int)std::floor(view.top / chunkPx), tileGrid.chunkY0);
+	int cx1 = std::min((int)std::floor((view.left + view.width) / chunkPx), tileGrid.chunkX0 + tileGrid.chunkCols - 1);
+	int cy1 = std::min((int)std::floor((view.top + view.height) / chunkPx), tileGrid.chunkY0 + tileGrid.chunkRows - 1);
+
+	updateChunkMeshes();
+	wallDrawCalls = 0;
+	for (int cy = cy0; cy <= cy1; cy++)
+		for (int cx = cx0; cx <= cx1; cx++) {
+			if (tileGrid.getChunk(cx, cy) == nullptr) continue;
+			ChunkMesh& mesh = chunkMeshes[getKey(cx, cy)];
+			if (mesh.isDirty) buildChunkMesh(cx, cy, mesh);
+			if (mesh.vertices.getVertexCount() == 0) continue;
+			win.draw(mesh.vertices, &wallAtlas);
+			wallDrawCalls++;
+		}
+	renderStats.wallChunksDrawn = wallDrawCalls;
+	renderStats.wallChunksCulled = tileGrid.getAllocatedChunks() - wallDrawCalls;
+}
+
+void WallMap::updateChunkMeshes() {
+	if (!changes.pull(meshSubscriber, changedCells)) {
+		for (auto& [key, mesh] : chunkMeshes) mesh.isDirty = true;
+		return;
+	}
+	for (const sf::IntRect& r : changedCells)
+		for (int cy = TileGrid::toChunk(r.top); cy <= TileGrid::toChunk(r.top + r.height - 1); cy++)
+			for (int cx = TileGrid::toChunk(r.left); cx <= TileGrid::toChunk(r.left + r.width - 1); cx++) {
+				auto it = chunkMeshes.find(getKey(cx, cy));
+				if (it != chunkMeshes.end()) it->second.isDirty = true;
+			}
+}
+
+void WallMap::buildChunkMesh(int cx, int cy, ChunkMesh& mesh) {
+	mesh.isDirty = false;
+	mesh.vertices.clear();
+	const TileGrid::Chunk* chunk = tileGrid.getChunk(cx, cy);
+	if (chunk == nullptr || chunk->count == 0) return;
+
+	const float g = (float)C::GRID_SIZE;
+	for (int ly = 0; ly < TileGrid::CHUNK_SIZE; ly++)
+		for (int lx = 0; lx < TileGrid::CHUNK_SIZE; lx++) {
+			uint8_t id = chunk->ids[(ly << TileGrid::CHUNK_SHIFT) | lx];
+			if (id == TileGrid::EMPTY) continue;
+			float x = (float)(cx * TileGrid::CHUNK_SIZE + lx) * g;
+			float y = (float)(cy * TileGrid::CHUNK_SIZE + ly) * g;
+			float u = (float)(id - 1) * g;
+			mesh.vertices.append(sf::Vertex({ x, y }, { u, 0.0f }));
+			mesh.vertices.append(sf::Vertex({ x + g, y }, { u + g, 0.0f }));
+			mesh.vertices.append(sf::Vertex({ x + g, y + g }, { u + g, g }));
+			mesh.vertices.append(sf::Vertex({ x, y + g }, { u, g }));
+		}
 }
 
 void WallMap::buildMap() {
-	buildLimits();
-	addAllBoxes();
+	if (!loadLevel(levelPath)) buildLimits();
 }
 
 void WallMap::buildLimits() {
@@ -107,232 +372,156 @@ void WallMap::buildLimits() {
 		addWall(Edge2, (cols * 3) - 1, i);
 }
 
-void WallMap::addAllBoxes() {
-	addWall(Ground, 3, 11);
-	addWall(Ground, 4, 11);
-	addWall(Ground, 5, 11);
-	addWall(Ground, 6, 11);
-	addWall(Box, 8, 14);
-	addWall(Box, 8, 15);
-	addWall(Ground, 9, 9);
-	addWall(Ground, 10, 9);
-	addWall(Ground, 11, 9);
-	addWall(Box, 11, 10);
-	addWall(Box, 11, 11);
-	addWall(Ground, 11, 12);
-	addWall(Ground, 12, 12);
-	addWall(Ground, 13, 12);
-	addWall(Ground, 14, 12);
-	addWall(Ground, 15, 12);
-	addWall(Ground, 16, 12);
-	addWall(Ground, 17, 12);
-	addWall(Ground, 17, 6);
-	addWall(Ground, 18, 6);
-	addWall(Ground, 19, 6);
-	addWall(Box, 20, 14);
-	addWall(Box, 20, 5);
-	addWall(Ground, 20, 6);
-	addWall(Box, 20, 15);
-	addWall(Box, 21, 14);
-	addWall(Box, 21, 15);
-	addWall(Box, 22, 14);
-	addWall(Box, 22, 15);
-	addWall(Box, 23, 14);
-	addWall(Box, 23, 15);
-	addWall(Box, 24, 14);
-	addWall(Box, 24, 15);
-	addWall(Box, 25, 14);
-	addWall(Box, 25, 15);
-	addWall(Box, 26, 14);
-	addWall(Box, 26, 15);
-	addWall(Box, 27, 14);
-	addWall(Box, 27, 15);
-	addWall(Box, 28, 14);
-	addWall(Box, 28, 15);
-	addWall(Box, 29, 14);
-	addWall(Box, 29, 15);
-	addWall(Box, 30, 14);
-	addWall(Box, 30, 15);
-	addWall(Box, 31, 14);
-	addWall(Box, 31, 15);
-	addWall(Box, 30, 3);
-	addWall(Box, 31, 3);
-	addWall(Box, 32, 3);
-	addWall(Ground, 34, 11);
-	addWall(Ground, 35, 11);
-	addWall(Ground, 36, 11);
-	addWall(Box, 38, 9);
-	addWall(Box, 39, 9);
-	addWall(Box, 40, 9);
-	addWall(Ground, 36, 6);
-	addWall(Ground, 35, 6);
-	addWall(Ground, 34, 6);
-	addWall(Ground, 39, 4);
-	addWall(Ground, 40, 4);
-	addWall(Ground, 41, 4);
-	addWall(Ground, 42, 4);
-	addWall(Ground, 43, 4);
-	addWall(Ground, 44, 4);
-	addWall(Ground, 59, 5);
-	addWall(Ground, 58, 5);
-	addWall(Ground, 57, 5);
-	addWall(Ground, 59, 9);
-	addWall(Ground, 58, 9);
-	addWall(Ground, 57, 9);
-	addWall(Ground, 59, 13);
-	addWall(Ground, 58, 13);
-	addWall(Ground, 57, 13);
-	addWall(Box, 47, 8);
-	addWall(Box, 50, 8);
-	addWall(Box, 51, 8);
-	addWall(Ground, 43, 10);
-	addWall(Ground, 44, 10);
-	addWall(Ground, 45, 10);
-	addWall(Box, 41, 15);
-	addWall(Box, 41, 14);
-	addWall(Box, 48, 8);
-	addWall(Box, 49, 8);
-	addWall(Ground, 60, 5);
-	addWall(Edge2, 60, 9);
-	addWall(Edge2, 60, 13);
-	addWall(Edge2, 60, 11);
-	addWall(Box, 60, 4);
-	addWall(Edge2, 60, 2);
-	addWall(Box, 61, 2);
-	addWall(Box, 62, 2);
-	addWall(Box, 64, 2);
-	addWall(Box, 65, 2);
-	addWall(Box, 66, 2);
-	addWall(Box, 67, 2);
-	addWall(Box, 68, 2);
-	addWall(Box, 69, 2);
-	addWall(Box, 70, 2);
-	addWall(Box, 63, 2);
-	addWall(Edge2, 60, 3);
-	addWall(Edge2, 60, 6);
-	addWall(Edge2, 60, 7);
-	addWall(Edge2, 60, 8);
-	addWall(Edge2, 60, 10);
-	addWall(Edge2, 60, 12);
-	addWall(Ground, 70, 3);
-	addWall(Ground, 71, 3);
-	addWall(Ground, 72, 3);
-	addWall(Ground, 73, 3);
-	addWall(Ground, 74, 3);
-	addWall(Box, 75, 3);
-	addWall(Box, 75, 4);
-	addWall(Box, 76, 4);
-	addWall(Box, 77, 4);
-	addWall(Box, 78, 4);
-	addWall(Box, 79, 4);
-	addWall(Box, 80, 4);
-	addWall(Edge2, 60, 14);
-	addWall(Ground, 61, 14);
-	addWall(Ground, 62, 14);
-	addWall(Ground, 61, 11);
-	addWall(Ground, 62, 11);
-	addWall(Ground, 61, 8);
-	addWall(Ground, 62, 8);
-	addWall(Ground, 61, 5);
-	addWall(Ground, 62, 5);
-	addWall(Box, 76, 19);
-	addWall(Ground, 68, 7);
-	addWall(Ground, 69, 7);
-	addWall(Ground, 70, 7);
-	addWall(Ground, 68, 11);
-	addWall(Ground, 69, 11);
-	addWall(Ground, 70, 11);
-	addWall(Ground, 74, 9);
-	addWall(Ground, 76, 9);
-	addWall(Ground, 75, 9);
-	addWall(Box, 73, 13);
-	addWall(Box, 74, 13);
-	addWall(Box, 71, 15);
-	addWall(Ground, 81, 12);
-	addWall(Ground, 82, 12);
-	addWall(Ground, 83, 12);
-	addWall(Ground, 84, 12);
-	addWall(Ground, 65, 15);
-	addWall(Ground, 66, 15);
-	addWall(Ground, 84, 9);
-	addWall(Ground, 85, 9);
-	addWall(Ground, 86, 9);
-	addWall(Ground, 87, 5);
-	addWall(Ground, 86, 5);
-	addWall(Ground, 85, 5);
-	addWall(Ground, 84, 5);
-	addWall(Box, 79, 7);
-	addWall(Box, 80, 7);
-}
-
-void WallMap::loadEnnemies() {
-	addEnemy({325.0f, 665.0f});
-	addEnemy({920.0f, 730.0f});
-	addEnemy({ 920.0f, 990.0f });
-	addEnemy({ 1200.0f, 350.0f });
-	addEnemy({ 1545.0f, 855.0f });
-	addEnemy({ 2010.0f, 155.0f });
-	addEnemy({ 3160.0f, 470.0f });
-	addEnemy({ 2530.0f, 535.0f });
-	addEnemy({ 2270.0f, 665.0f });
-	addEnemy({ 2815.0f, 985.0f });
-	addEnemy({ 3470.0f, 985.0f });
-	addEnemy({ 3740.0f, 795.0f });
-	addEnemy({ 3705.0f, 535.0f });
-	addEnemy({ 3780.0f, 275.0f });
-	addEnemy({ 3905.0f, 45.0f });
-	addEnemy({ 4325.0f, 85.0f });
-	addEnemy({ 5020.0f, 220.0f });
-	addEnemy({ 3945.0f, 285.0f });
-	addEnemy({ 3995.0f, 475.0f });
-	addEnemy({ 3940.0f, 670.0f });
-	addEnemy({ 3985.0f, 860.0f });
-	addEnemy({ 4410.0f, 415.0f });
-	addEnemy({ 4220.0f, 925.0f });
-	addEnemy({ 4445.0f, 665.0f });
-	addEnemy({ 5280.0f, 730.0f });
-	addEnemy({ 5120.0f, 415.0f });
-	addEnemy({ 4725.0f, 990.0f });
-	addEnemy({ 5465.0f, 540.0f });
-	addEnemy({ 5495.0f, 285.0f });
-	addEnemy({ 5155.0f, 900.0f });
-	addEnemy({ 4940.0f, 795.0f });
-	addEnemy({ 4840.0f, 395.0f });
-	addEnemy({ 4675.0f, 25.0f });
+// the level stays mapped by the streamer, only the chunks around the
+// player start are loaded here, the rest is paged in by streamAround
+bool WallMap::loadLevel(const std::string& path) {
+	if (!streamer.open(path)) return false;
+
+	tileGrid.clear();
+	walls.clear();
+	chunkMeshes.clear();
+	enemies.clear();
+	physics.resize(0);
+	deadEnemies.clear();
+	bullets.clear();
+	hitscanShots.clear();
+	enemyIndex.clear();
+	bulletIndex.clear();
+	pendingSpawns.clear();
+	parkedEnemies.clear();
+	changes.reset();
+
+	const LevelFile::Header& h = *streamer.level.header;
+	playerStart = { h.playerStartX, h.playerStartY };
+	int minX = h.minCellX;
+	int maxX = h.maxCellX;
+	getWallColumns(streamer.level, minX, maxX);
+	cameraMinX = minX * C::GRID_SIZE + C::RES_X / 2.0f;
+	cameraMaxX = std::max(cameraMinX, (maxX + 1) * C::GRID_SIZE - C::RES_X / 2.0f);
+	streamAround(playerStart, true);
+	return true;
 }
 
-uint64_t WallMap::getKey(int x, int y) {
-	return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+// The camera stops at the outer side walls, the leftmost Edge1 and the
+// rightmost Edge2 column: the floor can run on past them. Left as is when
+// the level has no side wall.
+void WallMap::getWallColumns(const LevelFile& level, int& minX, int& maxX) {
+	int left = INT_MAX;
+	int right = INT_MIN;
+	for (int i = 0; i < level.header->chunkCount; i++) {
+		const LevelFile::ChunkEntry& entry = level.chunkTable[i];
+		const uint8_t* ids = level.getTiles(entry);
+		for (int j = 0; j < TileGrid::CHUNK_CELLS; j++) {
+			int x = entry.cx * TileGrid::CHUNK_SIZE + (j & TileGrid::CHUNK_MASK);
+			if (ids[j] == Edge1 + 1) left = std::min(left, x);
+			else if (ids[j] == Edge2 + 1) right = std::max(right, x);
+		}
+	}
+	if (left != INT_MAX) minX = left;
+	if (right != INT_MIN) maxX = right;
 }
 
-bool WallMap::isWall(int x, int y) {
-	return wallIDs.find(getKey(x, y)) != wallIDs.end();
+void WallMap::loadTiles(const LevelFile& level, TileGrid& grid, std::vector<Wall>& pWalls) {
+	for (int i = 0; i < level.header->chunkCount; i++) {
+		const LevelFile::ChunkEntry& entry = level.chunkTable[i];
+		addChunkTiles(grid, pWalls, entry.cx, entry.cy, level.getTiles(entry));
+	}
+}
+
+void WallMap::addChunkTiles(TileGrid& grid, std::vector<Wall>& pWalls, int cx, int cy, const uint8_t* ids) {
+	grid.setChunk(cx, cy, ids);
+	for (int j = 0; j < TileGrid::CHUNK_CELLS; j++) {
+		if (ids[j] == TileGrid::EMPTY) continue;
+		int x = cx * TileGrid::CHUNK_SIZE + (j & TileGrid::CHUNK_MASK);
+		int y = cy * TileGrid::CHUNK_SIZE + (j >> TileGrid::CHUNK_SHIFT);
+		grid.setSlot(x, y, (int32_t)pWalls.size());
+		pWalls.push_back({ getKey(x, y), WallType(ids[j] - 1) });
+	}
+}
+
+// chunks that are not resident are written from their override or the file,
+// then the level is reopened from the new file
+bool WallMap::saveLevel(const std::string& path) {
+	std::vector<sf::Vector2f> spawns;
+	for (Enemy& e : enemies)
+		if (!e.isDead) spawns.push_back(e.startPos);
+	if (!streamer.isOpen()) return LevelFile::write(path, tileGrid, spawns, player.pos);
+
+	for (const PendingSpawn& s : pendingSpawns) spawns.push_back(s.pos);
+	for (const auto& [key, extra] : streamer.extraSpawns)
+		spawns.insert(spawns.end(), extra.begin(), extra.end());
+	for (int i = 0; i < (int)streamer.spawnStates.size(); i++)
+		if (streamer.spawnStates[i] == ChunkStreamer::Waiting)
+			spawns.push_back({ streamer.level.spawns[i].x, streamer.level.spawns[i].y });
+
+	std::vector<uint64_t> keys;
+	for (const auto& [key, index] : streamer.entries) keys.push_back(key);
+	for (const auto& [key, ids] : streamer.overrides) keys.push_back(key);
+	for (const auto& [key, slot] : streamer.slots) keys.push_back(key);
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+	TileGrid full;
+	ChunkStreamer::LoadedChunk loaded;
+	for (uint64_t key : keys) {
+		sf::Vector2i c = getVec2i(key);
+		auto slot = streamer.slots.find(key);
+		if (slot != streamer.slots.end() && slot->second.state == ChunkStreamer::Resident) {
+			const TileGrid::Chunk* chunk = tileGrid.getChunk(c.x, c.y);
+			if (chunk && chunk->count > 0) full.setChunk(c.x, c.y, chunk->ids.data());
+			continue;
+		}
+		streamer.loadNow(c.x, c.y, loaded);
+		full.setChunk(c.x, c.y, loaded.ids.data());
+	}
+
+	// the mapping has to be released before the file can be replaced
+	std::string tmpPath = path + ".tmp";
+	if (!LevelFile::write(tmpPath, full, spawns, player.pos)) return false;
+	streamer.close();
+	std::remove(path.c_str());
+	if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+		std::cout << "LEVEL SAVE ERROR, path : " << path << std::endl;
+		return false;
+	}
+	return loadLevel(path);
+}
+
+uint64_t WallMap::getKey(int x, int y) {
+	return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
 }
 
 void WallMap::addWall(WallType type, int x, int y) {
-	uint64_t key = getKey(x, y);
-	if (wallIDs.find(key) != wallIDs.end()) return;
-	wallIDs.emplace(key, type);
-	walls.push_back({ key, type, wallTextures });
+	ensureResident(x, y);
+	if (isWall(x, y)) return;
+	tileGrid.set(x, y, uint8_t(type) + 1);
+	tileGrid.setSlot(x, y, (int32_t)walls.size());
+	walls.push_back({ getKey(x, y), type });
+	changes.mark(x, y);
 }
 
+// swap-and-pop through the per-cell slot index: walls order is irrelevant
+// since rendering goes through the chunk meshes
 void WallMap::removeWall(int x, int y) {
+	ensureResident(x, y);
 	if (!isWall(x, y)) return;
-	uint64_t key = getKey(x, y);
-	wallIDs.erase(key);
-	for (int i = walls.size() - 1; i >= 0; i--)
-		if (walls[i].key == key) {
-			walls.erase(walls.begin() + i);
-			break;
-		}
+	int32_t slot = tileGrid.getSlot(x, y);
+	tileGrid.set(x, y, TileGrid::EMPTY);
+	popWall(slot);
+	changes.mark(x, y);
 }
 
-sf::Vector2i WallMap::getVec2i(uint64_t key) {
-	return { int32_t(key >> 32), int32_t(key & 0xFFFFFFFFu) };
+void WallMap::popWall(int32_t slot) {
+	if (slot != (int32_t)walls.size() - 1) {
+		walls[slot] = walls.back();
+		sf::Vector2i moved = getVec2i(walls[slot].key);
+		tileGrid.setSlot(moved.x, moved.y, slot);
+	}
+	walls.pop_back();
 }
 
-WallMap::WallType WallMap::getType(int x, int y) {
-	return wallIDs[getKey(x, y)];
+sf::Vector2i WallMap::getVec2i(uint64_t key) {
+	return { int32_t(key >> 32), int32_t(key & 0xFFFFFFFFu) };
 }
 
 void WallMap::destroyBox(int x, int y) {
@@ -342,6 +531,178 @@ void WallMap::destroyBox(int x, int y) {
 	removeWall(x, y);
 }
 
+// Amanatides-Woo grid traversal, dir must be normalized so distances are in pixels
+WallMap::RayHit WallMap::raycast(sf::Vector2f origin, sf::Vector2f dir, float maxDist, bool skipOrigin) {
+	RayHit hit;
+	const float g = (float)C::GRID_SIZE;
+	const float inf = std::numeric_limits<float>::infinity();
+	int cx = (int)std::floor(origin.x / g);
+	int cy = (int)std::floor(origin.y / g);
+
+	if (!skipOrigin && isWall(cx, cy)) {
+		hit.hit = true;
+		hit.cell = { cx, cy };
+		hit.type = getType(cx, cy);
+		return hit;
+	}
+
+	int stepX = (dir.x > 0.0f) ? 1 : ((dir.x < 0.0f) ? -1 : 0);
+	int stepY = (dir.y > 0.0f) ? 1 : ((dir.y < 0.0f) ? -1 : 0);
+	hit.dist = maxDist;
+	if (stepX == 0 && stepY == 0) return hit;
+
+	float tDeltaX = (stepX != 0) ? g / std::abs(dir.x) : inf;
+	float tDeltaY = (stepY != 0) ? g / std::abs(dir.y) : inf;
+	float tMaxX = (stepX > 0) ? ((cx + 1) * g - origin.x) / dir.x : ((stepX < 0) ? (cx * g - origin.x) / dir.x : inf);
+	float tMaxY = (stepY > 0) ? ((cy + 1) * g - origin.y) / dir.y : ((stepY < 0) ? (cy * g - origin.y) / dir.y : inf);
+
+	while (true) {
+		float t;
+		if (tMaxX < tMaxY) {
+			t = tMaxX;
+			tMaxX += tDeltaX;
+			cx += stepX;
+		}
+		else {
+			t = tMaxY;
+			tMaxY += tDeltaY;
+			cy += stepY;
+		}
+		if (t > maxDist) return hit;
+		if (isWall(cx, cy)) {
+			hit.hit = true;
+			hit.dist = t;
+			hit.cell = { cx, cy };
+			hit.type = getType(cx, cy);
+			return hit;
+		}
+	}
+}
+
+// rays are walked sorted by origin so neighbouring rays reuse the same chunks
+void WallMap::raycastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits, bool skipOrigin) {
+	hits.resize(rays.size());
+	rayOrder.resize(rays.size());
+	for (int i = 0; i < (int)rays.size(); i++) rayOrder[i] = i;
+	std::sort(rayOrder.begin(), rayOrder.end(), [&rays](int a, int b) {
+		if (rays[a].origin.x != rays[b].origin.x) return rays[a].origin.x < rays[b].origin.x;
+		return rays[a].origin.y < rays[b].origin.y;
+		});
+	for (int i : rayOrder) {
+		const Ray& r = rays[i];
+		hits[i] = raycast(r.origin, r.dir, r.maxDist, skipOrigin);
+	}
+}
+
+// The earliest of the wall hit already found along the segment, the player
+// box and the boxes of the live enemies along it (slab tests). On ties the
+// wall wins, then the player, then the lowest enemy id.
+WallMap::ShotHit WallMap::sweepShot(sf::Vector2f start, sf::Vector2f dir, float len, const RayHit& wall) {
+	ShotHit hit;
+	hit.wall = wall;
+	hit.isHit = wall.hit;
+	hit.dist = wall.hit ? wall.dist : len;
+
+	float t;
+	if (!player.isDead && rayIntersectsRect(start, dir, player.vBox, hit.dist, t) && (t < hit.dist || !hit.isHit)) {
+		hit.isHit = true;
+		hit.dist = t;
+		hit.target = &player;
+	}
+
+	// sorted so the first enemy hit is the same as in a full scan
+	enemyIndex.querySegment(start, start + dir * hit.dist, queryIds);
+	std::sort(queryIds.begin(), queryIds.end());
+	for (int id : queryIds) {
+		Enemy& e = enemies[id];
+		if (e.isDead || !rayIntersectsRect(start, dir, e.vBox, hit.dist, t)) continue;
+		if (t < hit.dist || !hit.isHit) {
+			hit.isHit = true;
+			hit.dist = t;
+			hit.target = hit.enemy = &e;
+		}
+	}
+	return hit;
+}
+
+// damage and box destruction shared by bullets and hitscan shots
+void WallMap::applyShotHit(const ShotHit& hit, sf::Vector2f dir) {
+	if (hit.target) {
+		hit.target->takeDamage(dir);
+		if (hit.enemy) hit.enemy->hasSeenPlayer = true;
+		return;
+	}
+	sf::Vector2i c = hit.wall.cell;
+	if (isWall(c.x, c.y) && getType(c.x, c.y) == Box) destroyBox(c.x, c.y);
+}
+
+void WallMap::fireHitscan(sf::Vector2f origin, float angle) {
+	hitscanShots.push_back({ origin, getForward(angle), angle });
+}
+
+// Shots fired during the tick, resolved once everything has moved: one
+// raycastBatch for the walls, then the hitboxes along each ray in firing
+// order, so an enemy killed by a shot is not hit by the next ones. The
+// walls are those at the start of the batch.
+void WallMap::resolveHitscan() {
+	hitscanShotsLastTick = (int)hitscanShots.size();
+	if (hitscanShots.empty()) return;
+
+	hitscanRays.clear();
+	for (const HitscanShot& s : hitscanShots) hitscanRays.push_back({ s.origin, s.dir, hitscanRange });
+	raycastBatch(hitscanRays, hitscanHits);
+
+	for (int i = 0; i < (int)hitscanShots.size(); i++) {
+		const HitscanShot& s = hitscanShots[i];
+		ShotHit hit = sweepShot(s.origin, s.dir, hitscanRange, hitscanHits[i]);
+		sf::Vector2f end = s.origin + s.dir * hit.dist;
+		EffectsManager::Instance().playTracer(s.origin, end);
+		if (!hit.isHit) continue;
+		BulletPool::playExplosion(end, s.dir, s.angle);
+		applyShotHit(hit, s.dir);
+	}
+	hitscanShots.clear();
+}
+
+// every enemy that may ask canSeePlayer this frame gets its ray resolved
+// in one batch, before any enemy moves
+void WallMap::resolveLineOfSight() {
+	if (!changes.pull(losSubscriber, changedCells)) losCache.clear();
+	else for (const sf::IntRect& r : changedCells) losCache.invalidate(r);
+	losCache.beginTick();
+
+	const float g = (float)C::GRID_SIZE;
+	sf::Vector2i playerCell = { (int)std::floor(player.pos.x / g), (int)std::floor(player.pos.y / g) };
+	losRays.clear();
+	losEnemies.clear();
+	losKeys.clear();
+	for (int i = 0; i < (int)enemies.size(); i++) {
+		Enemy& e = enemies[i];
+		e.hasLosResult = false;
+		if (e.isDead) continue;
+		sf::Vector2f d = player.pos - e.pos;
+		float len = std::sqrt(d.x * d.x + d.y * d.y);
+		if (!e.hasSeenPlayer && len > e.viewDistance) continue;
+
+		sf::Vector2i cell = { (int)std::floor(e.pos.x / g), (int)std::floor(e.pos.y / g) };
+		if (isLosCacheEnabled && losCache.find(cell, playerCell, e.losResult)) {
+			e.hasLosResult = true;
+			continue;
+		}
+		losRays.push_back({ e.pos, normalize(d), len });
+		losEnemies.push_back(i);
+		losKeys.push_back(LosCache::getKey(cell, playerCell));
+	}
+
+	raycastBatch(losRays, losHits, true);
+	for (int i = 0; i < (int)losEnemies.size(); i++) {
+		Enemy& e = enemies[losEnemies[i]];
+		e.hasLosResult = true;
+		e.losResult = !losHits[i].hit;
+		if (isLosCacheEnabled) losCache.store(LosCache::getFrom(losKeys[i]), playerCell, e.losResult);
+	}
+}
+
 void WallMap::loadBackgrounds() {
 	for (int i = 1; i <= 8; i++) {
 		sf::Texture tex;
@@ -435,4 +796,196 @@ void WallMap::drawBackgrounds() {
 void WallMap::addEnemy(sf::Vector2f pPos, bool isFromEditor) {
 	enemies.push_back(Enemy(pPos, *this, player, "res/sprites/enemy.png", { 43, 42 }));
 	if (isFromEditor) enemies.back().setForEditorInstance();
-}
\ No newline at end of file
+	enemyIndex.insert((int)enemies.size() - 1, enemies.back().vBox);
+}
+
+// Keeps the chunks overlapping the view (plus loadRadius) resident and
+// evicts the ones past evictRadius. Loads go through the streamer thread,
+// only a few finished chunks and spawns are integrated per frame.
+void WallMap::streamAround(sf::Vector2f center, bool isBlocking) {
+	if (!streamer.isOpen()) return;
+
+	const float chunkPx = (float)(TileGrid::CHUNK_SIZE * C::GRID_SIZE);
+	sf::Vector2f half = win.getView().getSize() * 0.5f;
+	int cx0 = (int)std::floor((center.x - half.x) / chunkPx);
+	int cy0 = (int)std::floor((center.y - half.y) / chunkPx);
+	int cx1 = (int)std::floor((center.x + half.x) / chunkPx);
+	int cy1 = (int)std::floor((center.y + half.y) / chunkPx);
+
+	int r = streamer.evictRadius;
+	for (auto it = streamer.slots.begin(); it != streamer.slots.end();) {
+		sf::Vector2i c = getVec2i(it->first);
+		if (c.x >= cx0 - r && c.x <= cx1 + r && c.y >= cy0 - r && c.y <= cy1 + r) {
+			++it;
+			continue;
+		}
+		ChunkStreamer::Slot slot = it->second;
+		streamer.nextGeneration(it->first);
+		it = streamer.slots.erase(it);
+		if (slot.state == ChunkStreamer::Resident) releaseChunk(c.x, c.y, slot.isEdited);
+	}
+	parkEnemies();
+
+	r = streamer.loadRadius;
+	ChunkStreamer::LoadedChunk loaded;
+	for (int cy = cy0 - r; cy <= cy1 + r; cy++)
+		for (int cx = cx0 - r; cx <= cx1 + r; cx++) {
+			uint64_t key = ChunkStreamer::getKey(cx, cy);
+			if (streamer.slots.count(key)) continue;
+			uint32_t generation = streamer.nextGeneration(key);
+			streamer.slots[key].generation = generation;
+			if (isBlocking && streamer.hasChunk(key)) {
+				streamer.loadNow(cx, cy, loaded);
+				integrateChunk(loaded);
+			}
+			else if (isBlocking || !streamer.request(cx, cy, generation))
+				streamer.slots[key].state = ChunkStreamer::Resident;
+			else
+				streamer.slots[key].state = ChunkStreamer::Queued;
+		}
+
+	// results of an older request (chunk evicted or loaded synchronously
+	// since) are dropped
+	int budget = streamer.maxChunksPerFrame;
+	while (budget > 0 && streamer.poll(loaded)) {
+		auto it = streamer.slots.find(ChunkStreamer::getKey(loaded.cx, loaded.cy));
+		if (it == streamer.slots.end() || it->second.state != ChunkStreamer::Queued
+			|| it->second.generation != loaded.generation) continue;
+		integrateChunk(loaded);
+		budget--;
+	}
+	spawnPending(isBlocking ? INT_MAX : streamer.maxSpawnsPerFrame);
+
+	renderStats.residentChunks = 0;
+	renderStats.queuedChunks = 0;
+	for (const auto& [key, slot] : streamer.slots)
+		(slot.state == ChunkStreamer::Resident ? renderStats.residentChunks : renderStats.queuedChunks)++;
+	renderStats.parkedEnemies = (int)parkedEnemies.size();
+}
+
+void WallMap::integrateChunk(const ChunkStreamer::LoadedChunk& loaded) {
+	uint64_t key = ChunkStreamer::getKey(loaded.cx, loaded.cy);
+	streamer.slots[key].state = ChunkStreamer::Resident;
+	addChunkTiles(tileGrid, walls, loaded.cx, loaded.cy, loaded.ids.data());
+	changes.markRect({ loaded.cx * TileGrid::CHUNK_SIZE, loaded.cy * TileGrid::CHUNK_SIZE, TileGrid::CHUNK_SIZE, TileGrid::CHUNK_SIZE });
+
+	for (int i = 0; i < (int)loaded.spawns.size(); i++) {
+		int spawnId = (int)loaded.spawnFirst + i;
+		if (streamer.spawnStates[spawnId] != ChunkStreamer::Waiting) continue;
+		streamer.spawnStates[spawnId] = ChunkStreamer::Spawned;
+		pendingSpawns.push_back({ loaded.spawns[i], spawnId });
+	}
+
+	auto extra = streamer.extraSpawns.find(key);
+	if (extra == streamer.extraSpawns.end()) return;
+	for (const sf::Vector2f& p : extra->second) pendingSpawns.push_back({ p, -1 });
+	streamer.extraSpawns.erase(extra);
+}
+
+// Edited chunks are kept as overrides, unless they are back to an empty
+// chunk the file does not know. Neighbours only allocated for their
+// derived border data are freed with it.
+void WallMap::releaseChunk(int cx, int cy, bool isEdited) {
+	uint64_t key = ChunkStreamer::getKey(cx, cy);
+	TileGrid::Chunk* chunk = tileGrid.getChunk(cx, cy);
+	if (isEdited) {
+		if (chunk && (chunk->count > 0 || streamer.entries.count(key)))
+			streamer.storeOverride(key, chunk->ids.data());
+		else if (chunk == nullptr && streamer.entries.count(key)) {
+			const std::array<uint8_t, TileGrid::CHUNK_CELLS> emptyIds{};
+			streamer.storeOverride(key, emptyIds.data());
+		}
+		else
+			streamer.dropOverride(key);
+	}
+
+	if (chunk) {
+		for (int i = 0; i < TileGrid::CHUNK_CELLS; i++)
+			if (chunk->ids[i] != TileGrid::EMPTY) popWall(chunk->slots[i]);
+		tileGrid.releaseChunk(cx, cy);
+	}
+	chunkMeshes.erase(getKey(cx, cy));
+	changes.markRect({ cx * TileGrid::CHUNK_SIZE, cy * TileGrid::CHUNK_SIZE, TileGrid::CHUNK_SIZE, TileGrid::CHUNK_SIZE });
+
+	for (int j = -1; j <= 1; j++)
+		for (int i = -1; i <= 1; i++) {
+			const TileGrid::Chunk* n = tileGrid.getChunk(cx + i, cy + j);
+			if (n && n->count == 0 && !streamer.slots.count(ChunkStreamer::getKey(cx + i, cy + j)))
+				tileGrid.releaseChunk(cx + i, cy + j);
+		}
+}
+
+// tile edits on a chunk that is still queued load it right away, so the
+// edit is not overwritten when the streamed copy arrives
+void WallMap::ensureResident(int x, int y) {
+	if (!streamer.isOpen()) return;
+	int cx = TileGrid::toChunk(x);
+	int cy = TileGrid::toChunk(y);
+	uint64_t key = ChunkStreamer::getKey(cx, cy);
+	auto it = streamer.slots.find(key);
+	if (it == streamer.slots.end() || it->second.state != ChunkStreamer::Resident) {
+		ChunkStreamer::LoadedChunk loaded;
+		streamer.loadNow(cx, cy, loaded);
+		streamer.slots[key].generation = streamer.nextGeneration(key);
+		integrateChunk(loaded);
+	}
+	streamer.slots[key].isEdited = true;
+}
+
+bool WallMap::isResident(sf::Vector2f pPos) {
+	int cx = TileGrid::toChunk((int)std::floor(pPos.x / C::GRID_SIZE));
+	int cy = TileGrid::toChunk((int)std::floor(pPos.y / C::GRID_SIZE));
+	auto it = streamer.slots.find(ChunkStreamer::getKey(cx, cy));
+	return it != streamer.slots.end() && it->second.state == ChunkStreamer::Resident;
+}
+
+// enemies standing on an evicted chunk are parked: their instance is kept
+// for the next spawn and their spawn goes back to waiting (or killed)
+void WallMap::parkEnemies() {
+	for (int i = 0; i < (int)enemies.size(); i++) {
+		Enemy& e = enemies[i];
+		if (e.isStreamedOut || isResident(e.pos)) continue;
+		if (e.spawnId >= 0)
+			streamer.spawnStates[e.spawnId] = e.isDead ? ChunkStreamer::Killed : ChunkStreamer::Waiting;
+		else if (!e.isDead) {
+			int cx = TileGrid::toChunk((int)std::floor(e.startPos.x / C::GRID_SIZE));
+			int cy = TileGrid::toChunk((int)std::floor(e.startPos.y / C::GRID_SIZE));
+			streamer.extraSpawns[ChunkStreamer::getKey(cx, cy)].push_back(e.startPos);
+		}
+		e.isStreamedOut = true;
+		e.isDead = true;
+		parkedEnemies.push_back(i);
+	}
+}
+
+void WallMap::spawnPending(int budget) {
+	while (budget > 0 && !pendingSpawns.empty()) {
+		PendingSpawn s = pendingSpawns.front();
+		pendingSpawns.pop_front();
+		if (isResident(s.pos)) {
+			spawnEnemy(s.pos, s.spawnId);
+			budget--;
+		}
+		else if (s.spawnId >= 0)
+			streamer.spawnStates[s.spawnId] = ChunkStreamer::Waiting;
+		else {
+			int cx = TileGrid::toChunk((int)std::floor(s.pos.x / C::GRID_SIZE));
+			int cy = TileGrid::toChunk((int)std::floor(s.pos.y / C::GRID_SIZE));
+			streamer.extraSpawns[ChunkStreamer::getKey(cx, cy)].push_back(s.pos);
+		}
+	}
+}
+
+void WallMap::spawnEnemy(sf::Vector2f pPos, int spawnId) {
+	if (parkedEnemies.empty()) {
+		addEnemy(pPos);
+		enemies.back().spawnId = spawnId;
+		return;
+	}
+	int parkedId = parkedEnemies.back();
+	Enemy& e = enemies[parkedId];
+	parkedEnemies.pop_back();
+	e.respawn(pPos);
+	e.spawnId = spawnId;
+	enemyIndex.insert(parkedId, e.vBox);
+}
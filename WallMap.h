@@ -13,6 +13,16 @@
 #include <SFML/Graphics.hpp>
 
 #include "C.hpp"
+#include "TileGrid.h"
+#include "SpatialHash.h"
+#include "LevelFile.h"
+#include "ChunkStreamer.h"
+#include "ChangeLog.h"
+#include "PhysicsWorld.h"
+#include "JobSystem.h"
+#include "LosCache.h"
+#include "NavGraph.h"
+#include "BulletPool.h"
 #include "Enemy.h"
 
 class Player;
@@ -31,14 +41,72 @@ public:
 	};
 
 	struct Wall {
-		Wall(uint64_t pKey, WallType pType, std::unordered_map<WallType, sf::Texture>& pWallTextures);
 		uint64_t key;
 		WallType type;
-		sf::Sprite sprite;
+	};
+
+	struct Ray {
+		sf::Vector2f origin;
+		sf::Vector2f dir;
+		float maxDist;
+	};
+
+	struct RayHit {
+		bool hit = false;
+		float dist = 0.0f;
+		sf::Vector2i cell;
+		WallType type = Ground;
+	};
+
+	// first thing a shot along a segment runs into, see sweepShot
+	struct ShotHit {
+		bool isHit = false;
+		float dist = 0.0f;
+		RayHit wall;
+		Entity* target = nullptr;	// nullptr when the shot stops on a wall
+		Enemy* enemy = nullptr;
+	};
+
+	struct HitscanShot {
+		sf::Vector2f origin;
+		sf::Vector2f dir;
+		float angle;
+	};
+
+	struct RenderStats {
+		int wallChunksDrawn = 0;
+		int wallChunksCulled = 0;
+		int enemiesDrawn = 0;
+		int enemiesCulled = 0;
+		int bulletsDrawn = 0;
+		int bulletsCulled = 0;
+		int bulletDrawCalls = 0;
+		int residentChunks = 0;
+		int queuedChunks = 0;
+		int parkedEnemies = 0;
+	};
+
+	struct AiLodStats {
+		int full = 0;
+		int reduced = 0;
+		int asleep = 0;
+		int thinking = 0;
+	};
+
+	struct PendingSpawn {
+		sf::Vector2f pos;
+		int spawnId;
+	};
+
+	struct ChunkMesh {
+		sf::VertexArray vertices{ sf::Quads };
+		bool isDirty = true;
 	};
 
 	sf::RenderWindow& win;
 	sf::View camera;
+	sf::Vector2f prevCameraCenter;
+	float renderAlpha = 1.0f;
 	float shakeDuration;
 	float shakeStrength;
 	double shakeTimer;
@@ -47,18 +115,88 @@ public:
 	std::vector<std::vector<sf::Sprite>> backgrounds;
 	sf::Color bgTint = { 220,220,220 };
 
-	std::unordered_map<WallType, sf::Texture> wallTextures{};
-	std::unordered_map<uint64_t, WallType> wallIDs;
+	sf::Texture wallAtlas;
+	TileGrid tileGrid;
 	std::vector<Wall> walls;
+	std::unordered_map<uint64_t, ChunkMesh> chunkMeshes;
+	int wallDrawCalls = 0;
+
+	ChangeLog changes;
+	int meshSubscriber;
+	std::vector<sf::IntRect> changedCells;
+
+	SpatialHash enemyIndex;
+	SpatialHash bulletIndex;
+	std::vector<int> visibleIds;
+	std::vector<int> queryIds;
+	float cullMargin = 128.0f;
+	RenderStats renderStats;
+
+	std::vector<Ray> losRays;
+	std::vector<RayHit> losHits;
+	std::vector<int> losEnemies;
+	std::vector<uint64_t> losKeys;
+	LosCache losCache;
+	bool isLosCacheEnabled = true;
+	int losSubscriber;
+
+	// gravity is accY doubled, see Entity::applyGravity
+	NavGraph nav{ (float)C::GRID_SIZE, Entity::ENEMY_JUMP_SPEED, Entity::ACC_Y * 2.0f, Enemy::RUN_SPEED };
+	int navSubscriber;
+	int playerNavNode = -1;
+	std::vector<int> rayOrder;
+
+	std::string levelPath = "res/levels/level1.enjl";
+	sf::Vector2f playerStart = { 200.0f, 980.0f };
+	float cameraMinX = C::RES_X / 2.0f;
+	float cameraMaxX = C::RES_X * 2.5f;
+
+	ChunkStreamer streamer;
+	std::deque<PendingSpawn> pendingSpawns;
+	std::vector<int> parkedEnemies;
+	bool isStreamingBlocking = false;	// recordings and replays stream synchronously
+
+	PhysicsWorld physics;
+	JobSystem jobs;
+	int thinkGrain = 64;
+	double thinkTime = 0.0;
+
+	// enemies past aiFullRadius from the player think every aiReducedStep,
+	// past aiSleepRadius not at all; hits and nearby map edits wake them
+	// for aiWakeTime
+	bool isAiLodEnabled = true;
+	float aiFullRadius = C::RES_X * 1.0f;
+	float aiSleepRadius = C::RES_X * 3.0f;
+	float aiReducedStep = 0.1f;
+	float aiWakeTime = 3.0f;
+	float aiWakeMargin = 8.0f * C::GRID_SIZE;
+	int lodSubscriber;
+	std::vector<sf::IntRect> lodCells;
+	AiLodStats aiLodStats;
 
 	std::deque<Enemy> enemies{};
 	std::deque<Enemy> deadEnemies{};
-	std::vector<Bullet> bullets{};
+	BulletPool bullets;
+
+	// hitscan shots of the tick, resolved in one batch by resolveHitscan
+	std::vector<HitscanShot> hitscanShots;
+	std::vector<Ray> hitscanRays;
+	std::vector<RayHit> hitscanHits;
+	float hitscanRange = 2000.0f;
+	bool isEnemyHitscan = false;
+	int hitscanShotsLastTick = 0;
 	Player& player;
 
 
 	WallMap(sf::RenderWindow& pWin, Player& pPlayer);
 	void update(double dt);
+	void savePrevState();
+	uint64_t getStateChecksum() const;
+	void updateNavigation();
+	void updateEnemies(double dt);
+	void scheduleEnemies(double dt);
+	void wakeEnemiesNearEdits();
+	void updateEnemyPhysics(double dt);
 	void draw();
 	void updateCamera(double dt);
 	void shakeCamera(float duration, float strength);
@@ -67,21 +205,70 @@ public:
 	static uint64_t getKey(int x, int y);
 	static sf::Vector2i getVec2i(uint64_t key);
 	void loadWallTextures();
+	void drawWalls(const sf::FloatRect& view);
+	sf::FloatRect getViewRect(float margin);
+	void indexEnemies();
+	void indexBullets();
+	void updateChunkMeshes();
+	void buildChunkMesh(int cx, int cy, ChunkMesh& mesh);
 	void buildMap();
 	void buildLimits();
-	void addAllBoxes();
 	void addWall(WallType type, int x, int y);
 	void removeWall(int x, int y);
+	void popWall(int32_t slot);
 	bool isWall(int x, int y);
+	bool anyWallInRow(int y, int x0, int x1);
+	bool anyWallInCol(int x, int y0, int y1);
+	uint16_t getNav(int x, int y);
 	
 	WallType getType(int x, int y);
 	void destroyBox(int x, int y);
+	RayHit raycast(sf::Vector2f origin, sf::Vector2f dir, float maxDist, bool skipOrigin = false);
+	void raycastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits, bool skipOrigin = false);
+	void resolveLineOfSight();
+	ShotHit sweepShot(sf::Vector2f start, sf::Vector2f dir, float len, const RayHit& wall);
+	void applyShotHit(const ShotHit& hit, sf::Vector2f dir);
+	void fireHitscan(sf::Vector2f origin, float angle);
+	void resolveHitscan();
 
 	void loadBackgrounds();
 	void updateBackgrounds();
 	void drawBackgrounds();
 
-	void loadEnnemies();
+	bool loadLevel(const std::string& path);
+	bool saveLevel(const std::string& path);
+	static void getWallColumns(const LevelFile& level, int& minX, int& maxX);
+	static void loadTiles(const LevelFile& level, TileGrid& grid, std::vector<Wall>& pWalls);
+	static void addChunkTiles(TileGrid& grid, std::vector<Wall>& pWalls, int cx, int cy, const uint8_t* ids);
 	void addEnemy(sf::Vector2f pPos, bool isFromEditor = false);
+
+	void streamAround(sf::Vector2f center, bool isBlocking = false);
+	void integrateChunk(const ChunkStreamer::LoadedChunk& loaded);
+	void releaseChunk(int cx, int cy, bool isEdited);
+	void ensureResident(int x, int y);
+	bool isResident(sf::Vector2f pPos);
+	void parkEnemies();
+	void spawnPending(int budget);
+	void spawnEnemy(sf::Vector2f pPos, int spawnId);
 };
 
+inline bool WallMap::isWall(int x, int y) {
+	return tileGrid.get(x, y) != TileGrid::EMPTY;
+}
+
+inline bool WallMap::anyWallInRow(int y, int x0, int x1) {
+	return tileGrid.anyInRow(y, x0, x1);
+}
+
+inline bool WallMap::anyWallInCol(int x, int y0, int y1) {
+	return tileGrid.anyInCol(x, y0, y1);
+}
+
+inline uint16_t WallMap::getNav(int x, int y) {
+	return tileGrid.getNav(x, y);
+}
+
+inline WallMap::WallType WallMap::getType(int x, int y) {
+	uint8_t id = tileGrid.get(x, y);
+	return (id == TileGrid::EMPTY) ? Ground : WallType(id - 1);
+}